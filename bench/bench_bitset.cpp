@@ -0,0 +1,252 @@
+#include "../bitset.hpp"
+#include "../bit_matrix.hpp"
+#include "../bitset_join.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// simple wall clock benchmarks, run a release build
+
+template<typename F>
+static void run(const char *name, size_t ops, F f) {
+  // warm up once, report the best of a few rounds
+  f();
+  double best = 1e300;
+  for (int r = 0; r < 5; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+    best = std::min(best, d.count());
+  }
+  std::printf("%-32s %10.2f ns/op\n", name, best / ops);
+}
+
+static volatile size_t sink;
+
+static void bench_small() {
+  const size_t CNT = 4000;
+  const size_t OPS = 100000;
+
+  std::vector<size_t> idx(OPS);
+  for (auto &i : idx) i = random() % CNT;
+
+  run("small: set", OPS, [&] {
+    bitset b(CNT);
+    for (size_t i : idx) b.set(i, true);
+    sink = b.count();
+  });
+
+  bitset b(CNT);
+  for (size_t i = 0; i < OPS / 10; ++i) b.set(idx[i], true);
+
+  run("small: get", OPS, [&] {
+    size_t c = 0;
+    for (size_t i : idx) c += b.get(i);
+    sink = c;
+  });
+
+  run("small: iterate", b.count(), [&] {
+    size_t c = 0;
+    for (auto it = b.cbegin(); it != b.cend(); ++it) c += *it;
+    sink = c;
+  });
+
+  bitset o(CNT);
+  for (size_t i = OPS / 10; i < OPS / 5; ++i) o.set(idx[i], true);
+
+  run("small: and", 1, [&] { sink = (b & o).count(); });
+  run("small: or", 1, [&] { sink = (b | o).count(); });
+  run("small: or=", 1, [&] { bitset c = b; c |= o; sink = c.count(); });
+  run("small: subset", 1, [&] { sink = b <= o; });
+}
+
+static void bench_large() {
+  const size_t CNT = 10000000;
+  const size_t OPS = 100000;
+
+  std::vector<size_t> idx(OPS);
+  for (auto &i : idx) i = random() % CNT;
+
+  bitset b(CNT), o(CNT);
+  for (size_t i = 0; i < OPS; ++i) (i % 2 ? b : o).set(idx[i], true);
+
+  run("large: get", OPS, [&] {
+    size_t c = 0;
+    for (size_t i : idx) c += b.get(i);
+    sink = c;
+  });
+
+  std::vector<size_t> sorted = idx;
+  std::sort(sorted.begin(), sorted.end());
+  std::unique_ptr<bool[]> out(new bool[OPS]);
+  run("large: get_many", OPS, [&] {
+    b.get_many(sorted, std::span<bool>(out.get(), OPS));
+    sink = out[OPS / 2];
+  });
+
+  run("large: or", 1, [&] { sink = (b | o).count(); });
+  run("large: shift", 1, [&] { sink = (b << 100).count(); });
+
+  bitset c = b;
+  for (size_t i = 0; i < 100; ++i) c.set(idx[i], !c.get(idx[i]));
+  auto p = bitset::diff(b, c);
+  run("large: diff", 1, [&] { sink = bitset::diff(b, c).words.size(); });
+  run("large: apply", 1, [&] { bitset d = b; d.apply(p); sink = d.count(); });
+  run("large: copy and set", 1, [&] { bitset d = b; d.set(idx[0], true); sink = d.count(); });
+
+  std::vector<uint8_t> roaring = b.to_roaring();
+  run("large: to_roaring", 1, [&] { sink = b.to_roaring().size(); });
+  run("large: from_roaring", 1, [&] { bitset d; bitset::from_roaring(roaring, d); sink = d.count(); });
+  run("large: iterate and set()", 1, [&] {
+    bitset d; bitset::from_roaring(roaring, d);
+    bitset e(CNT);
+    for (auto it = d.cbegin(); it != d.cend(); ++it) e.set(*it, true);
+    sink = e.count();
+  });
+
+  std::vector<uint64_t> dense((CNT + 63) / 64);
+  b.to_words(dense.data());
+  run("large: from_words", 1, [&] { sink = bitset::from_words(dense.data(), dense.size()).count(); });
+  run("large: to_words", 1, [&] { b.to_words(dense.data()); sink = dense[0]; });
+
+  std::string text = b.to_string(), hex = b.to_hex(), ranges = b.to_ranges();
+  run("large: to_string", 1, [&] { sink = b.to_string().size(); });
+  run("large: from_string", 1, [&] { bitset d; bitset::from_string(text, d); sink = d.count(); });
+  run("large: to_hex", 1, [&] { sink = b.to_hex().size(); });
+  run("large: from_hex", 1, [&] { bitset d; bitset::from_hex(hex, d); sink = d.count(); });
+  run("large: to_ranges", 1, [&] { sink = b.to_ranges().size(); });
+  run("large: from_ranges", 1, [&] { bitset d; bitset::from_ranges(ranges, d); sink = d.count(); });
+
+  run("large: set() unsorted", OPS, [&] {
+    bitset d(CNT);
+    for (size_t i : idx) d.set(i, true);
+    sink = d.count();
+  });
+  run("large: from_unsorted", OPS, [&] { sink = bitset::from_unsorted(idx, CNT).count(); });
+  run("large: from_unsorted x4", OPS, [&] { sink = bitset::from_unsorted(idx, CNT, 4).count(); });
+}
+
+static void bench_matrix() {
+  const size_t N = 20000;
+  const size_t EDGES = 200000;
+
+  // sparse graph as separate rows and as a matrix
+  std::vector<bitset> rows(N, bitset(N));
+  bit_matrix m(N, N);
+  for (size_t i = 0; i < EDGES; ++i) {
+    size_t r = random() % N, c = random() % N;
+    rows[r].set(c, true);
+    m.set(r, c, true);
+  }
+
+  bitset frontier(N);
+  for (size_t i = 0; i < N / 10; ++i) frontier.set(random() % N, true);
+
+  run("matrix: step (vector<bitset>)", 1, [&] {
+    bitset next(N);
+    for (auto it = frontier.cbegin(); it != frontier.cend(); ++it) next |= rows[*it];
+    sink = next.count();
+  });
+  run("matrix: step (or_rows)", 1, [&] { sink = m.or_rows(frontier).count(); });
+  run("matrix: transpose", 1, [&] { sink = m.transpose().rows(); });
+}
+
+static void bench_join() {
+  const size_t N = 3000;
+  const size_t CNT = 20000;
+  const double THRESHOLD = 0.5;
+
+  // groups of similar sets with different cardinalities
+  std::vector<bitset> sets;
+  for (size_t i = 0; i < N; ++i) {
+    if (i % 8 == 0) {
+      bitset b(CNT);
+      size_t n = 50 + random() % 1000;
+      for (size_t k = 0; k < n; ++k) b.set(random() % CNT, true);
+      sets.push_back(b);
+    } else {
+      bitset b = sets.back();
+      for (size_t k = 0; k < 20; ++k) b.set(random() % CNT, random() % 2);
+      sets.push_back(b);
+    }
+  }
+
+  const size_t pairs = N * N;
+  run("join: similar (pairwise)", pairs, [&] {
+    size_t c = 0;
+    for (const bitset &a : sets)
+      for (const bitset &b : sets)
+        c += double((a & b).count()) >= THRESHOLD * double((a | b).count());
+    sink = c;
+  });
+  run("join: similar (1 thread)", pairs, [&] { sink = bitset_join(1).similar(sets, sets, THRESHOLD).size(); });
+  run("join: similar (threads)", pairs, [&] { sink = bitset_join().similar(sets, sets, THRESHOLD).size(); });
+
+  run("join: contained (pairwise)", pairs, [&] {
+    size_t c = 0;
+    for (const bitset &a : sets)
+      for (const bitset &b : sets)
+        c += a <= b;
+    sink = c;
+  });
+  run("join: contained (1 thread)", pairs, [&] { sink = bitset_join(1).contained(sets, sets).size(); });
+  run("join: contained (threads)", pairs, [&] { sink = bitset_join().contained(sets, sets).size(); });
+}
+
+static void bench_dense() {
+  const size_t CNT = 1000000;
+  const size_t OPS = 100000;
+
+  std::vector<size_t> idx(OPS);
+  for (auto &i : idx) i = random() % CNT;
+
+  // about half of the bits set, compressed (threshold above 1) and dense
+  bitset c(CNT), o(CNT);
+  c.dense_threshold(2);
+  o.dense_threshold(2);
+  for (size_t i = 0; i < CNT; ++i) {
+    if (random() % 2) c.set(i, true);
+    if (random() % 2) o.set(i, true);
+  }
+  bitset d = c, p = o;
+  d.dense_threshold(bitset::default_dense_threshold);
+  p.dense_threshold(bitset::default_dense_threshold);
+
+  for (const bitset *b : {&c, &d}) {
+    const bool dense = b->dense();
+    run(dense ? "dense: get" : "compressed: get", OPS, [&] {
+      size_t n = 0;
+      for (size_t i : idx) n += b->get(i);
+      sink = n;
+    });
+    run(dense ? "dense: set" : "compressed: set", OPS, [&] {
+      bitset e = *b;
+      for (size_t i : idx) e.set(i, !e.get(i));
+      sink = e.count();
+    });
+  }
+
+  run("compressed: or", 1, [&] { sink = (c | o).count(); });
+  run("dense: or", 1, [&] { sink = (d | p).count(); });
+  run("compressed: and=", 1, [&] { bitset e = c; e &= o; sink = e.count(); });
+  run("dense: and=", 1, [&] { bitset e = d; e &= p; sink = e.count(); });
+
+  bitset s(CNT);
+  for (size_t i = 0; i < OPS / 10; ++i) s.set(idx[i], true);
+  run("compressed: or= sparse", 1, [&] { bitset e = c; e |= s; sink = e.count(); });
+  run("dense: or= sparse", 1, [&] { bitset e = d; e |= s; sink = e.count(); });
+}
+
+int main() {
+  bench_small();
+  bench_large();
+  bench_matrix();
+  bench_join();
+  bench_dense();
+  return 0;
+}
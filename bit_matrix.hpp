@@ -0,0 +1,375 @@
+#ifndef BIT_MATRIX_HPP
+#define BIT_MATRIX_HPP
+
+#include "bitset.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Matrix of bit rows in a single arena.
+ * @details Every row is stored in the compressed layout of basic_bitset, all
+ * rows live in one contiguous vector and a directory keeps the position of
+ * each row. Rows only keep the metadata words up to their last non-empty
+ * block, so empty and sparse rows take a few words while dense rows stay
+ * dense.
+ *
+ * A row that grows is moved to the end of the arena, the space it leaves
+ * behind is reclaimed once more than half of the arena is unused.
+ */
+template<typename Word = uint64_t, unsigned FanOut = sizeof(Word) * CHAR_BIT - 1>
+class basic_bit_matrix {
+public:
+  using bitset_type = basic_bitset<Word, FanOut>;
+
+  /** Binary operations on rows. */
+  enum class op { intersect, unite, symmetric_difference, difference };
+
+  basic_bit_matrix() = default;
+  /** Creates an empty matrix, columns are bit positions of the rows. */
+  basic_bit_matrix(size_t rows, size_t cols);
+
+  size_t rows() const { return _dir.size(); }
+  size_t cols() const { return _cols; }
+
+  bool get(size_t r, size_t c) const;
+  void set(size_t r, size_t c, bool value);
+
+  /** Copies row r into a bitset with a capacity of at least cols(). */
+  bitset_type row(size_t r) const;
+  /** Replaces row r, b must not contain bits beyond cols(). */
+  void set_row(size_t r, const bitset_type &b);
+  /** Counts the set bits of row r. */
+  size_t count(size_t r) const;
+
+  /**
+   * @brief Updates row r with o(row r, row s).
+   * @return if row r changed
+   */
+  bool apply(op o, size_t r, size_t s);
+  /** Updates row r with o(row r, b), returns if row r changed. */
+  bool apply(op o, size_t r, const bitset_type &b);
+
+  /**
+   * @brief Unites all rows selected by the bits of rows.
+   * @details With the adjacency matrix of a graph this is one step of a
+   * reachability search from the vertices in rows.
+   */
+  bitset_type or_rows(const bitset_type &rows) const;
+
+  /** Creates the transposed matrix, blocked by one metadata block of columns at a time. */
+  basic_bit_matrix transpose() const;
+
+  /** Number of words in the arena, including unused ones. */
+  size_t arena_size() const { return _arena.size(); }
+  /** Moves all rows together, drops the unused words of the arena. */
+  void compact();
+
+private:
+  using bitstore = typename bitset_type::bitstore;
+  using words_t = typename bitset_type::words_t;
+
+  static constexpr size_t BITS = bitset_type::word_bits;
+  static constexpr size_t MS = bitset_type::fan_out;
+  static constexpr size_t MMS = bitset_type::block_bits;
+  static constexpr Word M_NEXT_MSK = bitset_type::M_NEXT_MSK;
+  static constexpr Word M_DATA_MSK = bitset_type::M_DATA_MSK;
+
+  struct entry {
+    size_t off;  // position in the arena
+    size_t meta; // number of metadata words
+    size_t len;  // number of words
+  };
+
+  words_t words(size_t r) const { return {_arena.data() + _dir[r].off, _dir[r].len}; }
+  /** Stores the words of a trimmed row, w must not point into the arena. */
+  void store(size_t r, words_t w);
+  /** Drops the bits of a row at or beyond cols(). */
+  void clip(bitstore &b) const;
+  static typename bitset_type::op_t function(op o);
+
+  std::vector<Word> _arena;
+  std::vector<entry> _dir;
+  size_t _cols{0};
+  size_t _unused{0}; // words in the arena not used by any row
+};
+
+using bit_matrix = basic_bit_matrix<>;
+
+template<typename Word, unsigned FanOut>
+basic_bit_matrix<Word, FanOut>::basic_bit_matrix(size_t rows, size_t cols)
+    : _arena(rows, 0), _dir(rows), _cols(cols) {
+  // every row starts with a single empty metadata word
+  for (size_t r = 0; r < rows; ++r)
+    _dir[r] = entry{r, 1, 1};
+}
+
+template<typename Word, unsigned FanOut>
+bool basic_bit_matrix<Word, FanOut>::get(size_t r, size_t c) const {
+  assert(r < rows() && c < cols());
+  const entry &d = _dir[r];
+  if (c / MMS >= d.meta)
+    return false;
+  const Word *p = _arena.data() + d.off;
+  if (!bitset_type::get_bit(p[c / MMS], (c / BITS) % MS))
+    return false;
+  return bitset_type::get_bit(p[bitset_type::get_offset(p, c)], c % BITS);
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bit_matrix<Word, FanOut>::set(size_t r, size_t c, bool value) {
+  assert(r < rows() && c < cols());
+  const entry &d = _dir[r];
+  if (c / MMS < d.meta && bitset_type::get_bit(_arena[d.off + c / MMS], (c / BITS) % MS)) {
+    // the data word exists, change it in place if it stays non-empty
+    Word &v = _arena[d.off + bitset_type::get_offset(_arena.data() + d.off, c)];
+    Word n = value ? v | (Word(1) << (c % BITS)) : v & ~(Word(1) << (c % BITS));
+    if (n) {
+      v = n;
+      return;
+    }
+  } else if (!value) {
+    return;
+  }
+
+  // the layout of the row changes
+  bitset_type b = row(r);
+  b.set(c, value);
+  set_row(r, b);
+}
+
+template<typename Word, unsigned FanOut>
+typename basic_bit_matrix<Word, FanOut>::bitset_type basic_bit_matrix<Word, FanOut>::row(size_t r) const {
+  words_t w = words(r);
+  bitstore b(w.begin(), w.end());
+  size_t n = _cols ? (_cols - 1) / MMS + 1 : 1;
+  if (_dir[r].meta < n)
+    bitset_type::grow(b, _dir[r].meta, n);
+  return bitset_type(std::move(b), count(r));
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bit_matrix<Word, FanOut>::set_row(size_t r, const bitset_type &b) {
+  // rows are stored without empty data words
+  bitstore w = b.dense() ? bitset_type::sparse(b.bits()) : b.bits();
+  bitset_type::trim(w);
+  assert(_cols == 0 || bitset_type::meta_words(w) <= (_cols - 1) / MMS + 1);
+  store(r, w);
+}
+
+template<typename Word, unsigned FanOut>
+size_t basic_bit_matrix<Word, FanOut>::count(size_t r) const {
+  size_t cnt = 0;
+  words_t w = words(r);
+  for (size_t i = _dir[r].meta; i < w.size(); ++i)
+    cnt += bitset_detail::count_bits(w[i]);
+  return cnt;
+}
+
+template<typename Word, unsigned FanOut>
+bool basic_bit_matrix<Word, FanOut>::apply(op o, size_t r, size_t s) {
+  bitstore out = bitset_type::combine(words(r), words(s), function(o), nullptr);
+  bitset_type::trim(out);
+  // trimmed rows have a unique layout
+  if (std::ranges::equal(out, words(r)))
+    return false;
+  store(r, out);
+  return true;
+}
+
+template<typename Word, unsigned FanOut>
+bool basic_bit_matrix<Word, FanOut>::apply(op o, size_t r, const bitset_type &b) {
+  bitstore out = bitset_type::combine(words(r), b.bits(), function(o), nullptr);
+  // b may hold bits beyond the columns
+  clip(out);
+  bitset_type::trim(out);
+  if (std::ranges::equal(out, words(r)))
+    return false;
+  store(r, out);
+  return true;
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bit_matrix<Word, FanOut>::clip(bitstore &b) const {
+  using namespace bitset_detail;
+  const size_t n = _cols ? (_cols - 1) / MMS + 1 : 1;
+  size_t m = bitset_type::meta_words(b);
+  if (m < n)
+    return;
+
+  // data words of the last kept block start at d
+  size_t d = m;
+  for (size_t i = 0; i + 1 < n; ++i)
+    d += count_bits(b[i], M_DATA_MSK);
+  if (m > n) {
+    // the data words of the dropped blocks follow the last kept block
+    b.erase(b.begin() + d + count_bits(b[n-1], M_DATA_MSK), b.end());
+    b.erase(b.begin() + n, b.begin() + m);
+    b[n-1] &= ~M_NEXT_MSK;
+    d -= m - n;
+  }
+
+  // clear the bits at or beyond _cols in the last kept block
+  Word &meta = b[n-1];
+  size_t p;
+  for (Word u = meta & M_DATA_MSK; first_bit(u, p); u &= u - 1) {
+    const size_t w = (n - 1) * MS + p;
+    if (w * BITS >= _cols)
+      b[d] = 0;
+    else if ((w + 1) * BITS > _cols)
+      b[d] &= msk_lo<Word>(_cols % BITS);
+    if (b[d]) {
+      ++d;
+      continue;
+    }
+    b.erase(b.begin() + d);
+    clear_bit(meta, p);
+  }
+}
+
+template<typename Word, unsigned FanOut>
+typename basic_bit_matrix<Word, FanOut>::bitset_type basic_bit_matrix<Word, FanOut>::or_rows(const bitset_type &rows) const {
+  const size_t n = _cols ? (_cols - 1) / MMS + 1 : 1;
+  // accumulate in dense words, only the touched blocks are collected
+  std::vector<Word> acc(n * MS);
+  std::vector<bool> hit(n);
+  for (auto it = rows.cbegin(); it != rows.cend(); ++it) {
+    assert(*it < this->rows());
+    const entry &d = _dir[*it];
+    const Word *p = _arena.data() + d.off + d.meta;
+    for (size_t m = 0; m < d.meta; ++m) {
+      Word md = _arena[d.off + m] & M_DATA_MSK;
+      hit[m] = hit[m] || md;
+      size_t q;
+      for (; bitset_detail::first_bit(md, q); md &= md - 1)
+        acc[m * MS + q] |= *(p++);
+    }
+  }
+
+  typename bitset_type::builder out(n);
+  for (size_t m = 0; m < n; ++m) {
+    if (!hit[m]) continue;
+    for (size_t w = m * MS; w < (m + 1) * MS; ++w)
+      out.push(w, acc[w]);
+  }
+  return bitset_type(std::move(out.out), out.cnt);
+}
+
+template<typename Word, unsigned FanOut>
+basic_bit_matrix<Word, FanOut> basic_bit_matrix<Word, FanOut>::transpose() const {
+  using namespace bitset_detail;
+  // data words of the transposed rows as (column, value), the word index is
+  // ascending per column since the row blocks are walked in order
+  struct item { size_t c; size_t w; Word v; };
+  std::vector<item> items;
+
+  // a block of BITS rows forms one data word in each transposed row, the
+  // columns are walked one metadata block at a time to keep the tile in cache
+  std::vector<Word> tile(MMS);
+  std::vector<size_t> touched;
+  std::vector<const Word *> data(BITS);
+  for (size_t r0 = 0; r0 < rows(); r0 += BITS) {
+    const size_t h = std::min(BITS, rows() - r0);
+    size_t n = 0;
+    for (size_t i = 0; i < h; ++i) {
+      const entry &d = _dir[r0 + i];
+      data[i] = _arena.data() + d.off + d.meta;
+      n = std::max(n, d.meta);
+    }
+
+    for (size_t m = 0; m < n; ++m) {
+      for (size_t i = 0; i < h; ++i) {
+        const entry &d = _dir[r0 + i];
+        if (m >= d.meta) continue;
+        size_t p, q;
+        for (Word md = _arena[d.off + m] & M_DATA_MSK; first_bit(md, p); md &= md - 1) {
+          for (Word v = *(data[i]++); first_bit(v, q); v &= v - 1) {
+            size_t c = p * BITS + q;
+            if (!tile[c]) touched.push_back(c);
+            tile[c] |= Word(1) << i;
+          }
+        }
+      }
+
+      for (size_t c : touched) {
+        items.push_back(item{m * MMS + c, r0 / BITS, tile[c]});
+        tile[c] = 0;
+      }
+      touched.clear();
+    }
+  }
+
+  // group the items by column (stable counting sort)
+  std::vector<size_t> first(_cols + 1);
+  for (const item &i : items) ++first[i.c + 1];
+  for (size_t c = 0; c < _cols; ++c) first[c + 1] += first[c];
+  std::vector<std::pair<size_t, Word>> sorted(items.size());
+  {
+    std::vector<size_t> pos(first.begin(), first.end() - 1);
+    for (const item &i : items) sorted[pos[i.c]++] = {i.w, i.v};
+  }
+
+  basic_bit_matrix t;
+  t._cols = rows();
+  t._dir.resize(_cols);
+  for (size_t c = 0; c < _cols; ++c) {
+    // only the metadata words up to the last data word are needed
+    size_t n = first[c] == first[c + 1] ? 1 : sorted[first[c + 1] - 1].first / MS + 1;
+    size_t off = t._arena.size();
+    t._arena.resize(off + n, M_NEXT_MSK);
+    t._arena.back() = 0;
+    for (size_t i = first[c]; i < first[c + 1]; ++i) {
+      auto [w, v] = sorted[i];
+      bitset_detail::set_bit(t._arena[off + w / MS], w % MS);
+      t._arena.push_back(v);
+    }
+    t._dir[c] = entry{off, n, t._arena.size() - off};
+  }
+  return t;
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bit_matrix<Word, FanOut>::compact() {
+  std::vector<Word> arena;
+  arena.reserve(_arena.size() - _unused);
+  for (entry &d : _dir) {
+    arena.insert(arena.end(), _arena.begin() + d.off, _arena.begin() + d.off + d.len);
+    d.off = arena.size() - d.len;
+  }
+  _arena = std::move(arena);
+  _unused = 0;
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bit_matrix<Word, FanOut>::store(size_t r, words_t w) {
+  entry &d = _dir[r];
+  if (w.size() <= d.len) {
+    // fits into the old place
+    std::copy(w.begin(), w.end(), _arena.begin() + d.off);
+    _unused += d.len - w.size();
+  } else {
+    _unused += d.len;
+    d.off = _arena.size();
+    _arena.insert(_arena.end(), w.begin(), w.end());
+  }
+  d.len = w.size();
+  d.meta = bitset_type::meta_words(w);
+
+  if (_unused > _arena.size() / 2)
+    compact();
+}
+
+template<typename Word, unsigned FanOut>
+typename basic_bitset<Word, FanOut>::op_t basic_bit_matrix<Word, FanOut>::function(op o) {
+  switch (o) {
+    case op::intersect: return [](Word a, Word b) -> Word { return a & b; };
+    case op::unite: return [](Word a, Word b) -> Word { return a | b; };
+    case op::symmetric_difference: return [](Word a, Word b) -> Word { return a ^ b; };
+    case op::difference: return [](Word a, Word b) -> Word { return a ^ (a & b); };
+  }
+  return nullptr;
+}
+
+#endif //BIT_MATRIX_HPP
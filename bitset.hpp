@@ -2,43 +2,137 @@
 #define BITSET_HPP
 
 #include <vector>
+#include <bitset>
 #include <string>
+#include <string_view>
+#include <atomic>
+#include <climits>
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
 
-#define BITS   (sizeof(uint64_t) * 8)
+namespace bitset_detail {
 
-// mask the n-th bit
-#define MSK_BT(N)  (1ULL << (N))
+/** Copyable atomic with relaxed ordering, used for caches that are filled in const methods. */
+template<typename T>
+struct relaxed {
+  relaxed(T v = T()) noexcept : _v(v) { }
+  relaxed(const relaxed &o) noexcept : _v(o.load()) { }
+  relaxed &operator=(const relaxed &o) noexcept { store(o.load()); return *this; }
 
-// metadate capacity
-#define MS     ((sizeof(uint64_t) * 8) - 1)
-// bits per metadata block
-#define MMS    (MS * BITS)
-// metadata position and offset of a bit
-#define MP(b)  ((b) / (BITS * MS))
-#define MO(b)  (((b) / BITS) % MS)
+  T load() const noexcept { return _v.load(std::memory_order_relaxed); }
+  void store(T v) noexcept { _v.store(v, std::memory_order_relaxed); }
 
-/** Extract the n-th bit of b. */
-static inline constexpr bool get_bit(uint64_t b, unsigned n) {
-  return b & MSK_BT(n);
-}
+private:
+  std::atomic<T> _v;
+};
 
-unsigned get_offset(const uint64_t *md, size_t index);
+/**
+ * Reference counted pointer for copy-on-write values.
+ * The count is atomic, unique() acquires the releases of dropped copies,
+ * so a value can be modified in place once no other copy is left.
+ */
+template<typename T>
+class cow_ptr {
+  struct node {
+    template<typename... A>
+    explicit node(A&&... a) : value(std::forward<A>(a)...) { }
+
+    std::atomic<size_t> refs{1};
+    T value;
+  };
 
-class bitset {
 public:
-  bitset() noexcept;
-  explicit bitset(size_t size) noexcept;
+  template<typename... A>
+  static cow_ptr make(A&&... a) { return cow_ptr(new node(std::forward<A>(a)...)); }
+
+  cow_ptr() noexcept = default;
+  cow_ptr(const cow_ptr &o) noexcept : _n(o._n) {
+    if (_n) _n->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  cow_ptr(cow_ptr &&o) noexcept : _n(std::exchange(o._n, nullptr)) { }
+  cow_ptr &operator=(cow_ptr o) noexcept { std::swap(_n, o._n); return *this; }
+  ~cow_ptr() {
+    if (_n && _n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete _n;
+  }
+
+  const T &operator*() const noexcept { return _n->value; }
+  const T *operator->() const noexcept { return &_n->value; }
+  bool operator==(const cow_ptr &o) const noexcept { return _n == o._n; }
+
+  /** Checks if this is the only copy. */
+  bool unique() const noexcept { return _n->refs.load(std::memory_order_acquire) == 1; }
+
+  /** Gets the value for a modification, copies it first if it is shared. */
+  T &mut() {
+    if (!unique()) *this = make(_n->value);
+    return _n->value;
+  }
+
+private:
+  explicit cow_ptr(node *n) noexcept : _n(n) { }
+
+  node *_n{};
+};
+
+} // namespace bitset_detail
+
+template<typename Word, unsigned FanOut>
+class basic_bit_matrix;
+template<typename Word, unsigned FanOut>
+class basic_bitset_join;
+
+/**
+ * @brief Compressed bitset.
+ * @details The bitset is stored in a single vector of words. The leading
+ * metadata words mark which data words are present, the data words follow
+ * in ascending order. Each metadata word covers FanOut data words, its
+ * highest bit marks if another metadata word follows. Empty data words are
+ * dropped, unless most data words are present: then all of them are kept
+ * (dense layout, see dense_threshold()).
+ *
+ * Copies share the vector (copy-on-write), the first modification through
+ * set(), clear(), resize() or the in-place operators detaches it. The
+ * sharing is reference counted atomically, so copies can be handed to
+ * other threads.
+ *
+ * @tparam Word unsigned integer type of the metadata and data words
+ * @tparam FanOut number of data words per metadata word
+ */
+template<typename Word = uint64_t, unsigned FanOut = sizeof(Word) * CHAR_BIT - 1>
+class basic_bitset {
+  static_assert(std::is_unsigned_v<Word> && !std::is_same_v<Word, bool>, "Word must be an unsigned integer type");
+  static_assert(FanOut > 0 && FanOut < sizeof(Word) * CHAR_BIT, "FanOut must leave the highest bit for the next flag");
+
+public:
+  using word_type = Word;
+
+  /** Number of bits per word. */
+  static constexpr size_t word_bits = sizeof(Word) * CHAR_BIT;
+  /** Number of data words covered by a metadata word. */
+  static constexpr size_t fan_out = FanOut;
+  /** Number of bits covered by a metadata word. */
+  static constexpr size_t block_bits = word_bits * fan_out;
+
+  basic_bitset();
+  explicit basic_bitset(size_t size);
 
   void set(size_t index, bool value);
 
   inline bool get(size_t index) const {
-    unsigned mp = MP(index), mo = MO(index);
+    const bitstore &b = bits();
+    if (_dense)
+      return get_bit(b[b.size() / (MS + 1) + index / BITS], index % BITS);
+    size_t mp = MP(index), mo = MO(index);
     // check if the corresponding data field exists
-    if (!get_bit(_bits[mp], mo))
+    if (!get_bit(b[mp], mo))
       return false;
-    return get_bit(_bits[get_offset(_bits.data(), index)], index % BITS);
+    return get_bit(b[get_offset(b.data(), index)], index % BITS);
   }
 
 
@@ -46,7 +140,81 @@ public:
     return get(index);
   }
 
-  /** Clears the bitset. */
+  /**
+   * @brief Looks up many bits at once.
+   * @details The indices must be sorted in ascending order. A single cursor
+   * runs over the metadata, so the cost is one pass instead of one
+   * metadata scan per index.
+   * @param out receives get(indices[i]) at position i
+   */
+  void get_many(std::span<const size_t> indices, std::span<bool> out) const;
+
+  /**
+   * @brief Sets many bits to the same value at once.
+   * @details The indices must be sorted in ascending order. Existing data
+   * words are updated in place, the layout is rebuilt at most once if
+   * data words have to be inserted or removed.
+   */
+  void set_many(std::span<const size_t> indices, bool value);
+
+  /**
+   * @brief Creates a bitset of the given capacity with the bits at indices set.
+   * @details The indices may be unsorted and repeat. They are partitioned by
+   * metadata block (counting sort), each block is assembled in a dense
+   * buffer and the layout is emitted in a single pass. The blocks can be
+   * assembled by several threads.
+   */
+  static basic_bitset from_unsorted(std::span<const size_t> indices, size_t capacity, unsigned threads = 1);
+
+  /**
+   * @brief Sets the bits at unsorted indices, all below the capacity.
+   * @details The batch is loaded like from_unsorted() and merged in a single pass.
+   */
+  void append_unsorted(std::span<const size_t> indices, unsigned threads = 1);
+
+  /**
+   * @brief Creates a bitset from n dense 64 bit words, bit i is bit i % 64 of words[i / 64].
+   * @details Runs of zero words are skipped four words at a time (with AVX2 if available).
+   * The capacity is n * 64 rounded up to whole metadata blocks.
+   */
+  static basic_bitset from_words(const uint64_t *words, size_t n);
+
+  /** Writes the bits as dense 64 bit words, out must hold (capacity() + 63) / 64 words. */
+  void to_words(uint64_t *out) const;
+
+  /** Creates a bitset with capacity N from a std::bitset. */
+  template<size_t N>
+  static basic_bitset from_bitset(const std::bitset<N> &b);
+
+  /** Copies the bits below N into a std::bitset. */
+  template<size_t N>
+  std::bitset<N> to_bitset() const;
+
+  /** Creates a bitset with the size of b as capacity from a std::vector<bool>. */
+  static basic_bitset from_bools(const std::vector<bool> &b);
+
+  /** Copies the bits into a std::vector<bool> of size capacity(). */
+  std::vector<bool> to_bools() const;
+
+  /** Returned by select() if no such bit exists. */
+  static constexpr size_t npos = SIZE_MAX;
+
+  /**
+   * @brief Finds the position of the k-th set bit (counting from 0).
+   * @details Skips whole data words by their popcount, then the metadata
+   * words by theirs and selects within the final words.
+   * @return the position or npos if less than k + 1 bits are set
+   */
+  size_t select(size_t k) const;
+
+  /**
+   * @brief Draws n distinct set bits uniformly at random.
+   * @return the sorted positions, all set bits if less than n are set
+   */
+  template<typename URBG>
+  std::vector<size_t> sample(size_t n, URBG &&rng) const;
+
+  /** Clears the bitset, keeps the capacity and the allocated memory (see shrink_to_fit()). */
   void clear();
 
   /** Checks if the bitset is empty. */
@@ -55,74 +223,366 @@ public:
   /** Gets the current capacity of the bitset. */
   size_t capacity() const;
 
-  /** Resizes the bitset to accomondate at least size values. */
+  /**
+   * @brief Resizes the bitset to accomondate at least size values.
+   * @details The capacity is rounded up to whole metadata blocks. Shrinking
+   * drops the metadata words beyond the new capacity with their data words,
+   * the bits of the last kept block stay.
+   */
   void resize(size_t size);
 
-  /** Counts the number of bits set to true in the bitset. */
+  /** Releases the unused memory of the storage. */
+  void shrink_to_fit();
+
+  /**
+   * @brief Drops the trailing metadata words without data and releases the unused memory.
+   * @details The capacity shrinks to the last block with a set bit, the
+   * dense layout is only kept if the remaining blocks are mostly full.
+   */
+  void compact();
+
+  /**
+   * @brief Counts the number of bits set to true in the bitset.
+   * @details O(1) while the cardinality is tracked, a full scan otherwise.
+   */
   size_t count() const;
 
-  // bitwise operations
-  bitset operator&(const bitset& other) const;
-  bitset operator|(const bitset& other) const;
-  bitset operator^(const bitset& other) const;
+  /**
+   * @brief Enables or disables the maintained cardinality.
+   * @details Tracking is on by default. Results of binary operations
+   * inherit the setting of the left operand.
+   */
+  void track_count(bool enable);
+
+  /** Checks if the cardinality is maintained. */
+  bool count_tracked() const { return _count != untracked; }
+
+  /** Default of dense_threshold(). */
+  static constexpr float default_dense_threshold = 0.75f;
+
+  /**
+   * @brief Sets the fraction of non-empty data words from which on all data words are stored.
+   * @details In the dense layout every metadata bit is set and empty data
+   * words are kept, so get() and set() index the data directly and the
+   * binary operations run word by word. The bitset switches back once less
+   * than half of the threshold is non-empty. 0 keeps the bitset dense, a
+   * threshold above 1 disables the dense layout. Results of binary
+   * operations inherit the setting of the left operand.
+   */
+  void dense_threshold(float t);
+
+  /** Gets the threshold of the dense layout. */
+  float dense_threshold() const { return _dense_at; }
+
+  /** Checks if the dense layout is used. */
+  bool dense() const { return _dense; }
+
+  /** Checks if this bitset shares its storage with another one (copy-on-write). */
+  bool shares(const basic_bitset &other) const { return _store == other._store; }
+
+  // bitwise operations, the operands may differ in capacity
+  // (missing bits are treated as zero, the result has the larger capacity)
+  basic_bitset operator&(const basic_bitset& other) const;
+  basic_bitset operator|(const basic_bitset& other) const;
+  basic_bitset operator^(const basic_bitset& other) const;
   // not yet implemented (too expensive)
-  //bitset operator~() const;
+  //basic_bitset operator~() const;
 
   /**
    * @brief Subtracts the bits of another bitset from this one.
    * @details b1 - b2 is equivalent to b1 ^ (b1 & b2).
    */
-  bitset operator-(const bitset& other) const;
+  basic_bitset operator-(const basic_bitset& other) const;
 
-  void operator&=(const bitset& other);
-  void operator|=(const bitset& other);
-  void operator^=(const bitset& other);
+  // in-place operations only grow this bitset if the result needs it
+  void operator&=(const basic_bitset& other);
+  void operator|=(const basic_bitset& other);
+  void operator^=(const basic_bitset& other);
+  void operator-=(const basic_bitset& other);
 
-  // comparison
-  bool operator==(const bitset& other) const;
-  bool operator!=(const bitset& other) const;
+  /**
+   * @brief In-place operations reporting if any bit of this bitset changed.
+   * @details The change is detected in the same pass as the update, e.g. for
+   * fixpoint iterations without a copy and a comparison.
+   */
+  bool union_with(const basic_bitset& other);
+  bool intersect_with(const basic_bitset& other);
+  bool subtract_with(const basic_bitset& other);
+
+  /**
+   * @brief Moves every bit from position i to i + k.
+   * @details The capacity is kept, bits moved beyond it are dropped.
+   */
+  void shift_left(size_t k);
+
+  /**
+   * @brief Moves every bit from position i to i - k.
+   * @details Bits moved below zero are dropped.
+   */
+  void shift_right(size_t k);
+
+  /**
+   * @brief Creates a copy with every bit translated from position i to i + k.
+   * @details The capacity grows by k for positive offsets, so no bit is lost.
+   * Bits moved below zero by negative offsets are dropped.
+   */
+  basic_bitset offset_copy(ptrdiff_t k) const;
+
+  basic_bitset operator<<(size_t k) const { basic_bitset r(*this); r.shift_left(k); return r; }
+  basic_bitset operator>>(size_t k) const { basic_bitset r(*this); r.shift_right(k); return r; }
+  void operator<<=(size_t k) { shift_left(k); }
+  void operator>>=(size_t k) { shift_right(k); }
+
+  // comparison, the operands may differ in capacity
+  bool operator==(const basic_bitset& other) const;
+  bool operator!=(const basic_bitset& other) const;
 
   /**
    * @brief Checks if this bitset is a subset of another bitset.
    */
-  bool operator<=(const bitset& other) const;
-  bool operator>=(const bitset& other) const;
-  bool operator<(const bitset& other) const;
-  bool operator>(const bitset& other) const;
+  bool operator<=(const basic_bitset& other) const;
+  bool operator>=(const basic_bitset& other) const;
+  bool operator<(const basic_bitset& other) const;
+  bool operator>(const basic_bitset& other) const;
+
+  /**
+   * @brief Hashes the set bits, independent of the capacity.
+   * @details The hash is the xor of a mix of each data word with its
+   * position. It is cached and kept up to date by set(), other
+   * modifications drop the cache until the next call.
+   */
+  size_t hash() const;
+
+  /** Difference between two versions of a bitset, see diff() and apply(). */
+  struct patch {
+    size_t capacity{0}; // capacity needed to apply the patch
+    // changed data words as (index in words, old ^ new) in ascending order
+    std::vector<std::pair<size_t, Word>> words;
+
+    /** Encodes the patch, indices as varint gaps and words in little endian. */
+    std::vector<uint8_t> serialize() const;
+    /** Decodes a serialized patch, returns false if the input is malformed. */
+    static bool deserialize(std::span<const uint8_t> in, patch &out);
+
+    bool operator==(const patch &other) const = default;
+  };
+
+  /**
+   * @brief Computes the patch turning from into to.
+   * @details The metadata of both is walked together like in the binary
+   * operations, blocks with equal metadata and data are skipped as a whole.
+   */
+  static patch diff(const basic_bitset &from, const basic_bitset &to);
+
+  /**
+   * @brief Applies a patch computed from a bitset equal to this one.
+   * @details Changed data words are updated in place, the layout is rebuilt
+   * at most once if data words appear or vanish. Grows to the capacity of
+   * the patch but never shrinks.
+   */
+  void apply(const patch &p);
+
+  /**
+   * @brief Encodes the bitset in the portable Roaring format.
+   * @details Each chunk of 2^16 bits becomes an array, bitmap or run
+   * container, whichever is the smallest (like Roaring's run optimization).
+   * @return the encoding, empty if a bit at or beyond 2^32 is set
+   */
+  std::vector<uint8_t> to_roaring() const;
+
+  /**
+   * @brief Decodes the portable Roaring format, with or without run containers.
+   * @return false if the input is malformed, out is unchanged then
+   */
+  static bool from_roaring(std::span<const uint8_t> in, basic_bitset &out);
+
+  /**
+   * @brief Encodes the bitset as EWAH with 64 bit words.
+   * @details The layout of EWAHBoolArray<uint64_t>::write() in little endian:
+   * size in bits, number of words, the words and the position of the last
+   * marker word. The size in bits is one past the highest set bit.
+   */
+  std::vector<uint8_t> to_ewah() const;
 
+  /**
+   * @brief Decodes EWAH with 64 bit words, see to_ewah().
+   * @return false if the input is malformed, out is unchanged then
+   */
+  static bool from_ewah(std::span<const uint8_t> in, basic_bitset &out);
+
+  /**
+   * @brief Formats the bits as '0' and '1' in groups of 8, lowest bit first.
+   * @details The output stops after the last data word and does not cover
+   * the whole capacity: " ..." follows if the capacity goes beyond it, or
+   * "..." alone if no data word is present.
+   */
   std::string to_string() const;
-  using bitstore = std::vector<uint64_t>;
+
+  /**
+   * @brief Parses the output of to_string(), spaces are ignored.
+   * @details The capacity is the number of digits.
+   * @return false if the input is malformed, out is unchanged then
+   */
+  static bool from_string(std::string_view in, basic_bitset &out);
+
+  /** Formats the bits as a hexadecimal number without leading zeros, "0" if empty. */
+  std::string to_hex() const;
+
+  /**
+   * @brief Parses a hexadecimal number, optionally prefixed with "0x".
+   * @details The capacity is four bits per digit.
+   * @return false if the input is malformed, out is unchanged then
+   */
+  static bool from_hex(std::string_view in, basic_bitset &out);
+
+  /** Formats the runs of set bits as ascending ranges, e.g. "0-3,8,10-11". */
+  std::string to_ranges() const;
+
+  /**
+   * @brief Parses the output of to_ranges(), the ranges must be ascending and disjoint.
+   * @details The capacity is one past the last range. The whole input is
+   * validated before the storage for that capacity is allocated.
+   * @return false if the input is malformed, out is unchanged then
+   */
+  static bool from_ranges(std::string_view in, basic_bitset &out);
+
+  using bitstore = std::vector<Word>;
+  typedef Word (*op_t)(Word, Word);
+
+  /** Gets the offset in the data, based on the metadata and index. */
+  static size_t get_offset(const Word *md, size_t index);
 
   struct iterator {
     using iterator_category = std::forward_iterator_tag;
 
-    unsigned operator*() const;
+    size_t operator*() const;
     iterator& operator++();
     iterator operator++(int);
-    bool operator==(const iterator &other);
-    bool operator!=(const iterator &other);
+    bool operator==(const iterator &other) const;
+    bool operator!=(const iterator &other) const;
 
   private:
-    friend bitset;
+    friend basic_bitset;
 
-    explicit iterator(const bitset &bs);
-    static bitset::iterator begin(const bitset &bs);
-    static bitset::iterator end(const bitset &bs);
+    explicit iterator(const basic_bitset &bs);
+    static iterator begin(const basic_bitset &bs);
+    static iterator end(const basic_bitset &bs);
     void next();
+    /** Moves to the first bit of the next non-empty data word. */
+    void skip();
 
-    const bitset &_b;
-    bitstore::const_iterator _it_m;
-    bitstore::const_iterator _it_d;
+    const basic_bitset &_b;
+    typename bitstore::const_iterator _it_m;
+    typename bitstore::const_iterator _it_d;
     size_t _pos_m{}; // position inside the metadata word
     size_t _pos_d{}; // position inside the data word
   };
 
-  iterator cbegin() const { return bitset::iterator::begin(*this); };
-  iterator cend() const { return bitset::iterator::end(*this); };
+  iterator cbegin() const { return iterator::begin(*this); };
+  iterator cend() const { return iterator::end(*this); };
 
 private:
-  explicit bitset(bitstore &&v) noexcept;
-  bitstore _bits;
+  // the matrix stores rows in the bitset layout and shares the algorithms
+  friend class basic_bit_matrix<Word, FanOut>;
+  friend class basic_bitset_join<Word, FanOut>;
+
+  // geometry shorthands
+  static constexpr size_t BITS = word_bits;
+  static constexpr size_t MS = fan_out;
+  static constexpr size_t MMS = block_bits;
+  // bitmask of the next metadata identifier (MSBit) and data fields
+  static constexpr Word M_NEXT_MSK = Word(1) << (BITS - 1);
+  static constexpr Word M_DATA_MSK = Word(~Word(0)) >> (BITS - MS);
+
+  // metadata position and offset of a bit
+  static constexpr size_t MP(size_t b) { return b / MMS; }
+  static constexpr size_t MO(size_t b) { return (b / BITS) % MS; }
+
+  /** Extract the n-th bit of b. */
+  static constexpr bool get_bit(Word b, unsigned n) { return (b >> n) & 1; }
+
+  static constexpr size_t untracked = SIZE_MAX;
+  // hash of the empty set, zero marks a hash that is not cached
+  static constexpr size_t hash_seed = 0x2545f4914f6cdd1dULL;
+
+  struct builder;
+
+  /** Takes a compressed store, switches to the dense layout if the threshold is reached. */
+  basic_bitset(bitstore &&v, size_t count, float dense_at = default_dense_threshold);
+
+  const bitstore &bits() const { return *_store; }
+  /** Gets the store for a modification, detaches it from other copies first. */
+  bitstore &mut() { return _store.mut(); }
+  /** Replaces the store without copying a shared one. */
+  void replace(bitstore &&v);
+  /** Replaces the store with a compressed one and picks the layout. */
+  void assign(bitstore &&v);
+  /** Switches the layout if the density crossed a threshold. */
+  void retune();
+  /** Checks if the dense layout is kept with n metadata words and the given non-empty words. */
+  bool keeps_dense(size_t n, size_t words) const;
+  /** Switches to the dense layout, n is the number of metadata words. */
+  void densify(size_t n);
+  void sparsify();
+  /** Grows the dense layout from n1 to n metadata words. */
+  void grow_dense(size_t n1, size_t n);
+  void rehash(size_t w, Word o, Word v);
+  // the operations are templates, so op can be inlined into the word loops of the dense layout
+  template<typename Op>
+  basic_bitset combined(const basic_bitset &other, Op op) const;
+  template<typename Op>
+  bool updated(const basic_bitset &other, Op op);
+  template<typename Op>
+  bool updated_dense(const basic_bitset &other, Op op);
+
+  // the algorithms read words through spans, so rows of a bit matrix can be used directly
+  using words_t = std::span<const Word>;
+
+  static size_t meta_words(words_t b);
+  static void grow(bitstore &b, size_t cnt_m, size_t cnt_n);
+  static void trim(bitstore &b);
+  static bool subset_check(words_t a, words_t b, bool proper);
+  static bool same_words(words_t a, words_t b);
+  /** Copies b without empty data words. */
+  static bitstore sparse(words_t b);
+  static bitstore combine(words_t a, words_t b, op_t op, size_t *cnt);
+  static bool update(bitstore &a, words_t b, op_t op, size_t *cnt);
+  template<typename F>
+  static void each_word(words_t b, F f);
+  /** Calls f(i, x) for each non-empty 64 bit word x with its index i in ascending order. */
+  template<typename F>
+  static void each_word64(words_t b, F f);
+  /** Appends the 64 bit word x with index i to out. */
+  static void push64(builder &out, size_t i, uint64_t x);
+  /** Creates a bitset with capacity size from the values bit(i). */
+  template<typename F>
+  static basic_bitset from_bits(size_t size, F bit);
+  /** Calls f(i) for each set bit i below size in ascending order. */
+  template<typename F>
+  void each_bit(size_t size, F f) const;
+  static bitstore translate(const bitstore &b, size_t cnt_m, ptrdiff_t k, size_t *cnt);
+
+  using store_ptr = bitset_detail::cow_ptr<bitstore>;
+  store_ptr _store; // shared by copies until one is modified
+  size_t _count{0}; // number of set bits or untracked
+  mutable bitset_detail::relaxed<size_t> _hash; // cached hash or zero
+  size_t _words{0}; // non-empty data words in the dense layout
+  float _dense_at{default_dense_threshold};
+  bool _dense{false}; // all data words are stored, empty ones too
+};
+
+/** The default bitset with 64 bit words. */
+using bitset = basic_bitset<>;
+
+template<typename Word, unsigned FanOut>
+struct std::hash<basic_bitset<Word, FanOut>> {
+  size_t operator()(const basic_bitset<Word, FanOut> &b) const noexcept {
+    return b.hash();
+  }
 };
 
+#include "bitset_impl.hpp"
+
+extern template class basic_bitset<>;
+
 #endif //BITSET_HPP
@@ -0,0 +1,2152 @@
+#ifndef BITSET_IMPL_HPP
+#define BITSET_IMPL_HPP
+
+// implementation of basic_bitset, included by bitset.hpp
+
+#include <cassert>
+#include <climits>
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+#if defined(__BMI2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if __cplusplus >= 202002L
+#include <bit>
+#endif
+
+namespace bitset_detail {
+
+template<typename Word>
+inline constexpr unsigned bits = sizeof(Word) * CHAR_BIT;
+
+// mask the lower/upper n bits
+template<typename Word>
+inline constexpr Word msk_lo(const unsigned n) {
+  assert(n <= bits<Word>);
+  return n ? Word(~Word(0)) >> (bits<Word> - n) : 0;
+}
+
+template<typename Word>
+inline constexpr Word msk_hi(const unsigned n) {
+  assert(n <= bits<Word>);
+  return n ? Word(Word(~Word(0)) << (bits<Word> - n)) : 0;
+}
+
+// lowest bit
+template<typename Word>
+inline constexpr bool lb(Word x) {
+  return x & 1;
+}
+
+template<typename Word>
+inline constexpr unsigned count_bits(Word b, Word m = ~Word(0)) {
+#if __cplusplus >= 202002L
+  return std::popcount(Word(b & m));
+#else
+  return __builtin_popcountll(b & m);
+#endif
+}
+
+template<typename Word>
+inline constexpr unsigned count_zero_r(Word b) {
+#if __cplusplus >= 202002L
+  return std::countr_zero(b);
+#else
+  // not defined for 0
+  return b ? __builtin_ctzll(b) : bits<Word>;
+#endif
+}
+
+/** sets p to the index of the next 1 in b. returns true if one exist */
+template<typename Word>
+inline bool next_bit(Word b, size_t &p) {
+  assert(p < bits<Word>);
+  Word v = b & ~msk_lo<Word>(p + 1);
+  assert(!v || p < count_zero_r(v));
+  p = count_zero_r(v);
+  return v;
+}
+
+template<typename Word>
+inline bool first_bit(Word b, size_t &p) {
+  p = count_zero_r(b);
+  return b;
+}
+
+template<typename Word>
+inline void set_bit(Word &b, unsigned n) {
+  assert(n < bits<Word>);
+  b |= Word(1) << n;
+}
+
+template<typename Word>
+inline void clear_bit(Word &b, unsigned n) {
+  assert(n < bits<Word>);
+  b &= ~(Word(1) << n);
+}
+
+/** Counts the number of bits set in b within the first n bits. */
+template<typename Word>
+inline constexpr unsigned count_bits_lo(Word b, unsigned n) {
+  return count_bits(b, msk_lo<Word>(n));
+}
+
+/** Gets the index of the r-th set bit (counting from 0) in b, r must be less than the popcount. */
+template<typename Word>
+inline unsigned select_bit(Word b, unsigned r) {
+  assert(r < count_bits(b));
+#if defined(__BMI2__)
+  if constexpr (sizeof(Word) == sizeof(uint64_t))
+    return count_zero_r(Word(_pdep_u64(1ULL << r, b)));
+  else if constexpr (sizeof(Word) <= sizeof(uint32_t))
+    return count_zero_r(Word(_pdep_u32(1U << r, b)));
+#endif
+  for (; r; --r) b &= b - 1;
+  return count_zero_r(b);
+}
+
+/** Counts the leading zero words of p[0, n), four at a time. */
+inline size_t zero_words(const uint64_t *p, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    if (!_mm256_testz_si256(v, v)) break;
+  }
+#else
+  for (; i + 4 <= n; i += 4)
+    if (p[i] | p[i + 1] | p[i + 2] | p[i + 3]) break;
+#endif
+  while (i < n && !p[i]) ++i;
+  return i;
+}
+
+/** Mixes a data word v with its index w (in words). */
+inline uint64_t mix(uint64_t w, uint64_t v) {
+  // splitmix64 finalizer
+  uint64_t x = v ^ (w * 0x9e3779b97f4a7c15ULL);
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/** Checks if the bitset of a is a subset of b. */
+template<typename Word>
+inline bool subset(Word a, Word b) {
+  /*
+   * a b |  a & ~b
+   * ----+-------
+   * 0 0 |  0
+   * 0 1 |  0
+   * 1 0 |  1
+   * 1 1 |  0
+   */
+  return Word(a & ~b) == 0;
+}
+
+/** Appends the lower n bytes of v in little endian. */
+inline void put_le(std::vector<uint8_t> &out, uint64_t v, unsigned n) {
+  for (unsigned i = 0; i < n; ++i)
+    out.push_back(uint8_t(v >> (8 * i)));
+}
+
+/** Reads little endian values, fails instead of reading past the end. */
+struct le_reader {
+  std::span<const uint8_t> in;
+  size_t pos{0};
+
+  size_t left() const { return in.size() - pos; }
+
+  bool read(uint64_t &v, unsigned n) {
+    if (left() < n) return false;
+    v = 0;
+    for (unsigned i = 0; i < n; ++i)
+      v |= uint64_t(in[pos++]) << (8 * i);
+    return true;
+  }
+};
+
+} // namespace bitset_detail
+
+#define BITSET_TEMPLATE template<typename Word, unsigned FanOut>
+#define BITSET_T basic_bitset<Word, FanOut>
+
+BITSET_TEMPLATE
+BITSET_T::basic_bitset() : _store(store_ptr::make(1)), _hash(hash_seed) {
+  assert(bits()[0] == 0);
+}
+
+BITSET_TEMPLATE
+BITSET_T::basic_bitset(size_t size) : _store(store_ptr::make(MP(size-1) + 1, M_NEXT_MSK)), _hash(hash_seed) {
+  // clear the last entry
+  mut().back() = 0;
+}
+
+BITSET_TEMPLATE
+BITSET_T::basic_bitset(bitstore &&v, size_t count, float dense_at)
+    : _store(store_ptr::make(std::move(v))), _count(count), _dense_at(dense_at) {
+  retune();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::replace(bitstore &&v) {
+  if (_store.unique())
+    _store.mut() = std::move(v);
+  else
+    _store = store_ptr::make(std::move(v));
+}
+
+BITSET_TEMPLATE
+void BITSET_T::assign(bitstore &&v) {
+  replace(std::move(v));
+  _dense = false;
+  retune();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::dense_threshold(float t) {
+  _dense_at = t;
+  retune();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::retune() {
+  // the dense layout stores n metadata words and n * MS data words
+  const size_t n = _dense ? bits().size() / (MS + 1) : meta_words(bits());
+  const double slots = double(n * MS);
+  if (!_dense && bits().size() - n >= _dense_at * slots)
+    densify(n);
+  else if (_dense && !keeps_dense(n, _words))
+    sparsify();
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::keeps_dense(size_t n, size_t words) const {
+  return _dense_at <= 1 && words >= _dense_at / 2 * double(n * MS);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::densify(size_t n) {
+  assert(!_dense);
+  bitstore out(n + n * MS, 0);
+  std::fill(out.begin(), out.begin() + n, M_NEXT_MSK | M_DATA_MSK);
+  out[n-1] &= ~M_NEXT_MSK;
+  _words = bits().size() - n;
+  each_word(bits(), [&](size_t w, Word v) { out[n + w] = v; });
+  replace(std::move(out));
+  _dense = true;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::sparsify() {
+  assert(_dense);
+  replace(sparse(bits()));
+  _dense = false;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::grow_dense(size_t n1, size_t n) {
+  assert(_dense && n1 < n);
+  bitstore &b = mut();
+  b[n1-1] |= M_NEXT_MSK;
+  b.insert(b.begin() + n1, n - n1, M_NEXT_MSK | M_DATA_MSK);
+  b[n-1] &= ~M_NEXT_MSK;
+  b.resize(n + n * MS, 0);
+}
+
+BITSET_TEMPLATE
+typename BITSET_T::bitstore BITSET_T::sparse(words_t b) {
+  builder out(meta_words(b));
+  each_word(b, [&out](size_t w, Word v) { out.push(w, v); });
+  return std::move(out.out);
+}
+
+/** Counts the number of metadata words of b. */
+BITSET_TEMPLATE
+size_t BITSET_T::meta_words(words_t b) {
+  auto it = b.begin();
+  while(*(it++) & M_NEXT_MSK);
+  assert(it <= b.end());
+  return it - b.begin();
+}
+
+/** Grows the metadata of b from cnt_m to cnt_n words. */
+BITSET_TEMPLATE
+void BITSET_T::grow(bitstore &b, size_t cnt_m, size_t cnt_n) {
+  assert(cnt_m < cnt_n);
+  auto it = b.begin() + cnt_m;
+  *(it - 1) |= M_NEXT_MSK;
+
+  size_t n = cnt_n - cnt_m;
+  it = b.insert(it, n, M_NEXT_MSK);
+  *(it + n - 1) = 0x00;
+}
+
+/** Drops the trailing metadata words of b without data, keeps at least one. */
+BITSET_TEMPLATE
+void BITSET_T::trim(bitstore &b) {
+  size_t n = meta_words(b);
+  size_t k = n;
+  while (k > 1 && !(b[k-1] & M_DATA_MSK)) --k;
+  if (k == n)
+    return;
+  b.erase(b.begin() + k, b.begin() + n);
+  b[k-1] &= ~M_NEXT_MSK;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::resize(size_t size) {
+  using namespace bitset_detail;
+  const size_t n1 = meta_words(bits());
+  const size_t n = size ? MP(size-1) + 1 : 1;
+  if (n > n1) {
+    // check the density for the new capacity before the dense words are allocated
+    if (_dense && keeps_dense(n, _words)) {
+      grow_dense(n1, n);
+    } else {
+      if (_dense)
+        sparsify();
+      grow(mut(), n1, n);
+    }
+  }
+  if (n >= n1)
+    return;
+
+  // truncate the metadata and the data words of the dropped blocks
+  bitstore &b = mut();
+  size_t d = 0;
+  for (size_t m = 0; m < n; ++m)
+    d += count_bits(b[m], M_DATA_MSK);
+  auto tail = b.begin() + n1 + d;
+  if (tail != b.end()) {
+    if (count_tracked())
+      for (auto it = tail; it != b.end(); ++it) _count -= count_bits(*it);
+    if (_dense)
+      _words -= b.end() - tail - std::count(tail, b.end(), Word(0));
+    _hash.store(0);
+  }
+  b.erase(tail, b.end());
+  b.erase(b.begin() + n, b.begin() + n1);
+  b[n-1] &= ~M_NEXT_MSK;
+  if (_dense)
+    retune();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::shrink_to_fit() {
+  if (bits().capacity() > bits().size())
+    mut().shrink_to_fit();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::compact() {
+  // the dropped metadata has no data, count and hash stay
+  if (_dense)
+    sparsify();
+  size_t n = meta_words(bits());
+  if (n > 1 && !(bits()[n-1] & M_DATA_MSK))
+    trim(mut());
+  // a mostly full bitset goes back to the dense layout
+  retune();
+  shrink_to_fit();
+}
+
+// TODO: all with the same size? use a manager? Pass data offset via param from manager?
+
+BITSET_TEMPLATE
+size_t BITSET_T::get_offset(const Word *md, size_t index) {
+  using namespace bitset_detail;
+  size_t cnt = 0;
+  const Word *p = md;
+  while (index >= MMS) {
+    assert(*md & M_NEXT_MSK);
+    cnt += count_bits(*(p++), M_DATA_MSK);
+    index -= MMS;
+  }
+  assert(MP(index) == 0);
+  cnt += count_bits_lo(*p, MO(index));
+  // skip the remaining metadata blocks
+  while (*(p++) & M_NEXT_MSK);
+  return cnt + (p - md);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::set(size_t index, bool value) {
+  using namespace bitset_detail;
+  size_t mp = MP(index), mo = MO(index);
+  assert(capacity() >= index);
+  if (_dense) {
+    // all data words are stored, empty ones too
+    size_t d_idx = bits().size() / (MS + 1) + index / BITS;
+    if (get_bit(bits()[d_idx], index % BITS) == value) return;
+    Word &v = mut()[d_idx];
+    Word o = v;
+    (value ? set_bit<Word> : clear_bit<Word>)(v, index % BITS);
+    if (count_tracked())
+      value ? ++_count : --_count;
+    rehash(index / BITS, o, v);
+    if (!o) {
+      ++_words;
+    } else if (!v) {
+      --_words;
+      retune();
+    }
+    return;
+  }
+
+  bool mb = get_bit(bits()[mp], mo);
+
+  // no need to do anything
+  // TODO check if bool is normalize (and remove if so)
+  if (!mb && !value) return;
+
+  // get the index of the data field
+  size_t d_idx = get_offset(bits().data(), index);
+  if (mb && get_bit(bits()[d_idx], index % BITS) == value) return;
+
+  bitstore &b = mut();
+  // check if the corresponding data field exists
+  if (!mb) {
+    assert(value);
+    // insert the new field
+    b.insert(b.begin() + d_idx, 0x00);
+    set_bit(b[mp], mo);
+  }
+
+  Word o = b[d_idx];
+  bool old = get_bit(o, index % BITS);
+  (value ? set_bit<Word> : clear_bit<Word>)(b[d_idx], index % BITS);
+  if (count_tracked() && old != value)
+    value ? ++_count : --_count;
+  rehash(index / BITS, o, b[d_idx]);
+
+  // clear the data field if empty
+  if (b[d_idx] == 0x00) {
+    assert(!value);
+    b.erase(b.begin() + d_idx);
+    clear_bit(b[mp], mo);
+  }
+  if (!mb)
+    retune();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::get_many(std::span<const size_t> indices, std::span<bool> out) const {
+  using namespace bitset_detail;
+  assert(indices.size() == out.size());
+  assert(std::is_sorted(indices.begin(), indices.end()));
+
+  // cursor: metadata word m, its first data word d
+  size_t m = 0;
+  size_t d = meta_words(bits());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    size_t index = indices[i];
+    size_t mp = MP(index), mo = MO(index);
+    for (; m < mp; ++m) {
+      assert(bits()[m] & M_NEXT_MSK);
+      d += count_bits(bits()[m], M_DATA_MSK);
+    }
+    out[i] = get_bit(bits()[m], mo) && get_bit(bits()[d + count_bits_lo(bits()[m], mo)], index % BITS);
+  }
+}
+
+BITSET_TEMPLATE
+void BITSET_T::set_many(std::span<const size_t> indices, bool value) {
+  using namespace bitset_detail;
+  assert(std::is_sorted(indices.begin(), indices.end()));
+  assert(indices.empty() || indices.back() < capacity());
+
+  if (indices.empty())
+    return;
+
+  // update the existing data words in place, a shared store is only
+  // detached once the first word changes
+  words_t b = bits();
+  Word *p = nullptr;
+  bool rebuild = false;
+  size_t m = 0;
+  size_t n = meta_words(b);
+  size_t d = n;
+  for (size_t i = 0; i < indices.size();) {
+    size_t w = indices[i] / BITS;
+    Word x = 0;
+    for (; i < indices.size() && indices[i] / BITS == w; ++i)
+      set_bit(x, indices[i] % BITS);
+
+    for (; m < w / MS; ++m)
+      d += count_bits(b[m], M_DATA_MSK);
+    if (!get_bit(b[m], w % MS)) {
+      // a new data word is needed
+      rebuild = rebuild || value;
+      continue;
+    }
+
+    size_t k = d + count_bits_lo(b[m], w % MS);
+    Word o = b[k];
+    Word v = value ? o | x : o & ~x;
+    if (v == o)
+      continue;
+    if (!p) {
+      p = mut().data();
+      b = bits();
+    }
+    p[k] = v;
+    if (count_tracked())
+      _count += count_bits(v) - (ptrdiff_t) count_bits(o);
+    rehash(w, o, v);
+    if (_dense)
+      _words += (v != 0) - (o != 0);
+    // an empty data word must be removed
+    rebuild = rebuild || (!v && !_dense);
+  }
+
+  if (!rebuild) {
+    if (_dense)
+      retune();
+    return;
+  }
+
+  // merge the missing words and drop the empty ones in a single pass
+  builder out(n);
+  size_t i = 0;
+  const auto word = [&](size_t w) {
+    Word x = 0;
+    for (; i < indices.size() && indices[i] / BITS == w; ++i)
+      set_bit(x, indices[i] % BITS);
+    return x;
+  };
+  each_word(b, [&](size_t w, Word v) {
+    for (size_t t; i < indices.size() && (t = indices[i] / BITS) < w;) {
+      Word x = word(t);
+      if (value) out.push(t, x);
+    }
+    Word x = word(w);
+    out.push(w, value ? v | x : v & ~x);
+  });
+  while (i < indices.size()) {
+    size_t t = indices[i] / BITS;
+    Word x = word(t);
+    if (value) out.push(t, x);
+  }
+
+  assign(std::move(out.out));
+  if (count_tracked())
+    _count = out.cnt;
+  _hash.store(0);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::from_unsorted(std::span<const size_t> indices, size_t capacity, unsigned threads) {
+  using namespace bitset_detail;
+  static_assert(MMS <= 0x10000, "offsets within a block must fit 16 bits");
+  const size_t n = capacity ? MP(capacity-1) + 1 : 1;
+
+  // partition the offsets within their block by block
+  std::vector<size_t> first(n + 1);
+  for (size_t i : indices) {
+    assert(i < n * MMS);
+    ++first[MP(i) + 1];
+  }
+  for (size_t m = 0; m < n; ++m)
+    first[m + 1] += first[m];
+  std::vector<uint16_t> sorted(indices.size());
+  {
+    std::vector<size_t> pos(first.begin(), first.end() - 1);
+    for (size_t i : indices)
+      sorted[pos[MP(i)]++] = uint16_t(i % MMS);
+  }
+
+  bitstore out(n, M_NEXT_MSK);
+  out.back() = 0;
+
+  // assemble the blocks [m0, m1), the metadata is written directly
+  struct part {
+    bitstore data;
+    size_t cnt{0};
+  };
+  const auto build = [&](size_t m0, size_t m1, part &p) {
+    bitstore words(MS);
+    for (size_t m = m0; m < m1; ++m) {
+      if (first[m] == first[m + 1])
+        continue;
+      for (size_t k = first[m]; k < first[m + 1]; ++k)
+        set_bit(words[sorted[k] / BITS], sorted[k] % BITS);
+      for (size_t j = 0; j < MS; ++j) {
+        if (!words[j]) continue;
+        set_bit(out[m], j);
+        p.data.push_back(words[j]);
+        p.cnt += count_bits(words[j]);
+        words[j] = 0;
+      }
+    }
+  };
+
+  // split the blocks into ranges with about the same number of indices
+  const size_t t = std::clamp<size_t>(threads, 1, n);
+  std::vector<size_t> bounds(t + 1, n);
+  bounds[0] = 0;
+  for (size_t i = 1; i < t; ++i) {
+    size_t target = indices.size() * i / t;
+    size_t b = std::partition_point(first.begin(), first.end() - 1, [target](size_t f) { return f < target; }) - first.begin();
+    bounds[i] = std::max(bounds[i - 1], b);
+  }
+
+  std::vector<part> parts(t);
+  if (t == 1) {
+    build(0, n, parts[0]);
+  } else {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < t; ++i)
+      workers.emplace_back(build, bounds[i], bounds[i + 1], std::ref(parts[i]));
+    for (auto &w : workers)
+      w.join();
+  }
+
+  size_t cnt = 0;
+  for (part &p : parts) {
+    out.insert(out.end(), p.data.begin(), p.data.end());
+    cnt += p.cnt;
+  }
+  return basic_bitset(std::move(out), cnt);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::append_unsorted(std::span<const size_t> indices, unsigned threads) {
+  if (indices.empty())
+    return;
+  union_with(from_unsorted(indices, capacity(), threads));
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::from_words(const uint64_t *words, size_t n) {
+  using bitset_detail::zero_words;
+  builder b(n ? MP(n * 64 - 1) + 1 : 1);
+  size_t i = zero_words(words, n);
+  while (i < n) {
+    push64(b, i, words[i]);
+    ++i;
+    i += zero_words(words + i, n - i);
+  }
+  return basic_bitset(std::move(b.out), b.cnt);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::to_words(uint64_t *out) const {
+  size_t next = 0;
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    std::fill(out + next, out + i, 0);
+    out[i] = x;
+    next = i + 1;
+  });
+  std::fill(out + next, out + (capacity() + 63) / 64, 0);
+}
+
+BITSET_TEMPLATE
+template<size_t N>
+BITSET_T BITSET_T::from_bitset(const std::bitset<N> &b) {
+  return from_bits(N, [&b](size_t i) { return b[i]; });
+}
+
+BITSET_TEMPLATE
+template<size_t N>
+std::bitset<N> BITSET_T::to_bitset() const {
+  std::bitset<N> out;
+  each_bit(N, [&out](size_t i) { out.set(i); });
+  return out;
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::from_bools(const std::vector<bool> &b) {
+  return from_bits(b.size(), [&b](size_t i) { return b[i]; });
+}
+
+BITSET_TEMPLATE
+std::vector<bool> BITSET_T::to_bools() const {
+  std::vector<bool> out(capacity());
+  each_bit(out.size(), [&out](size_t i) { out[i] = true; });
+  return out;
+}
+
+BITSET_TEMPLATE
+template<typename F>
+BITSET_T BITSET_T::from_bits(size_t size, F bit) {
+  builder b(size ? MP(size - 1) + 1 : 1);
+  // pack 64 bits at a time, empty words are skipped by the builder
+  for (size_t i = 0; i < size; i += 64) {
+    uint64_t x = 0;
+    for (size_t k = 0, e = std::min<size_t>(64, size - i); k < e; ++k)
+      x |= uint64_t(bit(i + k)) << k;
+    push64(b, i / 64, x);
+  }
+  return basic_bitset(std::move(b.out), b.cnt);
+}
+
+BITSET_TEMPLATE
+template<typename F>
+void BITSET_T::each_bit(size_t size, F f) const {
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    size_t p;
+    for (; bitset_detail::first_bit(x, p) && i * 64 + p < size; x &= x - 1)
+      f(i * 64 + p);
+  });
+}
+
+BITSET_TEMPLATE
+size_t BITSET_T::select(size_t k) const {
+  using namespace bitset_detail;
+  const size_t n = meta_words(bits());
+  if (count_tracked() && k >= _count)
+    return npos;
+
+  // find the data word with the k-th bit
+  size_t j = n;
+  for (; j < bits().size(); ++j) {
+    size_t c = count_bits(bits()[j]);
+    if (k < c) break;
+    k -= c;
+  }
+  if (j == bits().size())
+    return npos;
+  const Word d = bits()[j];
+  j -= n;
+
+  // find the metadata word of the j-th data word
+  size_t m = 0;
+  for (;; ++m) {
+    assert(m < n);
+    size_t c = count_bits(bits()[m], M_DATA_MSK);
+    if (j < c) break;
+    j -= c;
+  }
+
+  size_t w = m * MS + select_bit(Word(bits()[m] & M_DATA_MSK), j);
+  return w * BITS + select_bit(d, k);
+}
+
+BITSET_TEMPLATE
+template<typename URBG>
+std::vector<size_t> BITSET_T::sample(size_t n, URBG &&rng) const {
+  using namespace bitset_detail;
+  const size_t cnt = count();
+  n = std::min(n, cnt);
+
+  // draw n distinct ranks (Floyd's algorithm)
+  std::vector<size_t> ranks;
+  ranks.reserve(n);
+  std::unordered_set<size_t> drawn;
+  for (size_t i = cnt - n; i < cnt; ++i) {
+    size_t r = std::uniform_int_distribution<size_t>(0, i)(rng);
+    if (!drawn.insert(r).second) {
+      drawn.insert(i);
+      r = i;
+    }
+    ranks.push_back(r);
+  }
+  std::sort(ranks.begin(), ranks.end());
+
+  // select all ranks in a single pass over the data words
+  std::vector<size_t> out;
+  out.reserve(n);
+  size_t i = 0;
+  size_t seen = 0;
+  each_word(bits(), [&](size_t w, Word v) {
+    size_t c = count_bits(v);
+    for (; i < ranks.size() && ranks[i] < seen + c; ++i)
+      out.push_back(w * BITS + select_bit(v, ranks[i] - seen));
+    seen += c;
+  });
+  assert(out.size() == n);
+  return out;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::clear() {
+  if (!_store.unique()) {
+    // don't copy the data of a shared store
+    bitstore b(meta_words(bits()), M_NEXT_MSK);
+    b.back() = 0;
+    _store = store_ptr::make(std::move(b));
+  } else {
+    bitstore &b = mut();
+    auto it = b.begin();
+    do {
+      *it &= M_NEXT_MSK;
+    } while(*(it++) & M_NEXT_MSK);
+    b.resize(it - b.begin());
+  }
+  if (count_tracked())
+    _count = 0;
+  _hash.store(hash_seed);
+  _dense = false;
+  _words = 0;
+  retune();
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::empty() const {
+  if (_dense)
+    return !_words;
+  auto it = bits().cbegin();
+  assert(it != bits().cend());
+  do {
+    if (*it & M_DATA_MSK) return false;
+  } while (*(it++) & M_NEXT_MSK);
+  return true;
+}
+
+BITSET_TEMPLATE
+size_t BITSET_T::capacity() const {
+  return MMS * meta_words(bits());
+}
+
+BITSET_TEMPLATE
+size_t BITSET_T::count() const {
+  if (count_tracked())
+    return _count;
+
+  size_t cnt = 0;
+  auto it = bits().cbegin();
+  while(*(it++) & M_NEXT_MSK);
+  while(it != bits().cend()) cnt += bitset_detail::count_bits(*(it++));
+  return cnt;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::track_count(bool enable) {
+  if (enable == count_tracked())
+    return;
+  _count = untracked;
+  if (enable)
+    _count = count();
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator==(const basic_bitset &other) const {
+  if (count_tracked() && other.count_tracked() && _count != other._count)
+    return false;
+  size_t h1 = _hash.load(), h2 = other._hash.load();
+  if (h1 && h2 && h1 != h2)
+    return false;
+
+  if (_dense || other._dense) {
+    if (_dense && other._dense && bits().size() == other.bits().size())
+      return _store == other._store || bits() == other.bits();
+    return same_words(bits(), other.bits());
+  }
+
+  size_t n1 = meta_words(bits());
+  size_t n2 = meta_words(other.bits());
+  if (n1 == n2)
+    return _store == other._store || bits() == other.bits();
+
+  // the missing metadata of the smaller bitset is treated as zero
+  for (size_t m = 0; m < std::max(n1, n2); ++m) {
+    Word v1 = m < n1 ? bits()[m] & M_DATA_MSK : 0;
+    Word v2 = m < n2 ? other.bits()[m] & M_DATA_MSK : 0;
+    if (v1 != v2) return false;
+  }
+  return std::equal(bits().cbegin() + n1, bits().cend(), other.bits().cbegin() + n2, other.bits().cend());
+}
+
+BITSET_TEMPLATE
+void BITSET_T::rehash(size_t w, Word o, Word v) {
+  using namespace bitset_detail;
+  size_t h = _hash.load();
+  if (!h) return;
+  // empty words are not part of the hash
+  if (o) h ^= mix(w, o);
+  if (v) h ^= mix(w, v);
+  _hash.store(h);
+}
+
+BITSET_TEMPLATE
+size_t BITSET_T::hash() const {
+  size_t h = _hash.load();
+  if (h) return h;
+
+  h = hash_seed;
+  each_word(bits(), [&h](size_t w, Word v) { h ^= bitset_detail::mix(w, v); });
+  _hash.store(h);
+  return h;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator!=(const basic_bitset &other) const {
+  return !(*this == other);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::subset_check(words_t a, words_t b, bool proper) {
+  using namespace bitset_detail;
+  size_t n1 = meta_words(a);
+  size_t n2 = meta_words(b);
+  size_t n = std::max(n1, n2);
+
+  // check metadata, the missing metadata of the smaller bitset is treated as zero
+  // (a word only present in a may be empty in the dense layout)
+  const bool dense = a.size() == n1 * (MS + 1);
+  if (!dense) {
+    for (size_t m = 0; m < n1; ++m) {
+      Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+      if (!subset(Word(a[m] & M_DATA_MSK), v2)) return false;
+    }
+  }
+
+  // check data, words only present in b only matter for proper subsets
+  bool equal = proper;
+  auto it1 = a.begin() + n1;
+  auto it2 = b.begin() + n2;
+  for (size_t m = 0; m < (proper ? n : n1); ++m) {
+    Word v1 = m < n1 ? a[m] & M_DATA_MSK : 0;
+    Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+    if (!equal) {
+      // only a matters, skip the words of b without a counterpart
+      if (!v1) {
+        it2 += count_bits(v2);
+        continue;
+      }
+    }
+    size_t p;
+    for (Word u = v1 | v2; first_bit(u, p); u &= u - 1) {
+      Word w1 = get_bit(v1, p) ? *(it1++) : 0;
+      Word w2 = get_bit(v2, p) ? *(it2++) : 0;
+      if (!subset(w1, w2)) return false;
+      equal = equal && (w1 == w2);
+    }
+  }
+
+  // check for proper => !equal
+  return !proper || !equal;
+}
+
+/** Compares the bits of a and b, empty data words may be stored (dense layout). */
+BITSET_TEMPLATE
+bool BITSET_T::same_words(words_t a, words_t b) {
+  using namespace bitset_detail;
+  size_t n1 = meta_words(a);
+  size_t n2 = meta_words(b);
+  auto it1 = a.begin() + n1;
+  auto it2 = b.begin() + n2;
+  for (size_t m = 0; m < std::max(n1, n2); ++m) {
+    Word v1 = m < n1 ? a[m] & M_DATA_MSK : 0;
+    Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+    size_t p;
+    for (Word u = v1 | v2; first_bit(u, p); u &= u - 1) {
+      Word w1 = get_bit(v1, p) ? *(it1++) : 0;
+      Word w2 = get_bit(v2, p) ? *(it2++) : 0;
+      if (w1 != w2) return false;
+    }
+  }
+  return true;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator<=(const basic_bitset &other) const {
+  return subset_check(bits(), other.bits(), false);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator>=(const basic_bitset &other) const {
+  return subset_check(other.bits(), bits(), false);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator<(const basic_bitset &other) const {
+  return subset_check(bits(), other.bits(), true);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::operator>(const basic_bitset &other) const {
+  return subset_check(other.bits(), bits(), true);
+}
+
+/**
+ * Combines a and b using op. Counts the set bits of the result in cnt if given.
+ * The result has the larger capacity of both, missing metadata is treated as zero.
+ */
+BITSET_TEMPLATE
+typename BITSET_T::bitstore BITSET_T::combine(words_t a, words_t b, const op_t op, size_t *cnt) {
+  using namespace bitset_detail;
+  size_t n1 = meta_words(a);
+  size_t n2 = meta_words(b);
+  size_t n = std::max(n1, n2);
+  auto it1 = a.begin() + n1;
+  auto it2 = b.begin() + n2;
+
+  bitstore out(n);
+
+  // check data
+  for (size_t m = 0; m < n; ++m) {
+    Word v1 = m < n1 ? a[m] & M_DATA_MSK : 0;
+    Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+    Word o = 0;
+    int rem = BITS - 1;
+    for (; v1 | v2; v1 >>= 1, v2 >>= 1, o >>= 1) {
+      -- rem;
+      Word a1 = lb(v1) ? *(it1++) : 0;
+      Word a2 = lb(v2) ? *(it2++) : 0;
+      Word v = op(a1, a2);
+      if (v) {
+        o |= M_NEXT_MSK;
+        out.push_back(v);
+        if (cnt) *cnt += count_bits(v);
+      }
+    }
+    assert(rem >= 0);
+    o >>= rem;
+    assert((o & M_DATA_MSK) == o);
+    out[m] = o | M_NEXT_MSK;
+  }
+  // clear the next bit for the last metadata word
+  out[n-1] &= ~M_NEXT_MSK;
+
+  return out;
+}
+
+BITSET_TEMPLATE
+template<typename Op>
+BITSET_T BITSET_T::combined(const basic_bitset &other, Op op) const {
+  if (_dense || other._dense) {
+    // update a copy, the dense words are combined in place word by word
+    basic_bitset r(*this);
+    if (other.capacity() > capacity())
+      r.resize(other.capacity());
+    r.updated(other, op);
+    return r;
+  }
+  size_t cnt = 0;
+  bitstore out = combine(bits(), other.bits(), op, count_tracked() ? &cnt : nullptr);
+  return basic_bitset(std::move(out), count_tracked() ? cnt : untracked, _dense_at);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::operator&(const basic_bitset &other) const {  // check metadata
+  const auto o = [](Word a, Word b) -> Word { return a & b; };
+  return combined(other, o);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::operator|(const basic_bitset &other) const {
+  const auto o = [](Word a, Word b) -> Word { return a | b; };
+  return combined(other, o);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::operator^(const basic_bitset &other) const {
+  const auto o = [](Word a, Word b) -> Word { return a ^ b; };
+  return combined(other, o);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::operator-(const basic_bitset &other) const {
+  const auto o = [](Word a, Word b) -> Word { return a ^ (a & b); };
+  return combined(other, o);
+}
+
+/**
+ * Updates a with op(a, b). Counts the set bits of the result in cnt if given.
+ * Missing metadata is treated as zero, a only grows if the result needs it.
+ * Returns if any data word of a changed.
+ */
+BITSET_TEMPLATE
+bool BITSET_T::update(bitstore &a, words_t b, const op_t op, size_t *cnt) {
+  using namespace bitset_detail;
+  size_t n1 = meta_words(a);
+  size_t n2 = meta_words(b);
+
+  // grow a if bits only set in b survive op
+  if (n2 > n1 && op(0, ~Word(0))) {
+    size_t n = n2;
+    while (n > n1 && !(b[n-1] & M_DATA_MSK)) --n;
+    if (n > n1) {
+      grow(a, n1, n);
+      n1 = n;
+    }
+  }
+
+  auto it1 = a.begin() + n1;
+  auto it2 = b.begin() + n2;
+  bool changed = false;
+
+  // check data
+  for (size_t m = 0; m < n1; ++m) {
+    Word v1 = a[m] & M_DATA_MSK;
+    Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+    Word o = 0;
+    int rem = BITS - 1;
+    for (; v1 | v2; v1 >>= 1, v2 >>= 1, o >>= 1) {
+      -- rem;
+      Word a1 = lb(v1) ? *(it1) : 0;
+      Word a2 = lb(v2) ? *(it2++) : 0;
+      Word v = op(a1, a2);
+      if (cnt) *cnt += count_bits(v);
+      changed = changed || v != a1;
+      if (lb(v1)) {
+        *it1 = v;
+        it1++;
+        o |= (v ? M_NEXT_MSK : 0);
+      } else if (v) {
+        it1 = a.insert(it1, v);
+        it1++;
+        o |= M_NEXT_MSK;
+      }
+    }
+    assert(rem >= 0);
+    o >>= rem;
+    a[m] = o | (a[m] & M_NEXT_MSK);
+  }
+
+  // clear all empty fields
+  a.erase(std::remove(a.begin() + n1, a.end(), 0), a.end());
+  return changed;
+}
+
+BITSET_TEMPLATE
+template<typename Op>
+bool BITSET_T::updated(const basic_bitset &other, Op op) {
+  words_t b = other.bits();
+  if (op(0, ~Word(0))) {
+    // pick the layout before growing: the result has at most the words of
+    // both and may grow to the capacity of other
+    const size_t n1 = _dense ? bits().size() / (MS + 1) : meta_words(bits());
+    const size_t n2 = other._dense ? b.size() / (MS + 1) : meta_words(b);
+    const size_t words = (_dense ? _words : bits().size() - n1) + (other._dense ? other._words : b.size() - n2);
+    const size_t n = std::max(n1, n2);
+    if (_dense && !keeps_dense(n, words))
+      sparsify();
+    // words only present in a dense other would be inserted one by one
+    else if (!_dense && other._dense && _dense_at <= 1 && words >= _dense_at * double(n * MS))
+      densify(n1);
+  }
+  if (_dense)
+    return updated_dense(other, op);
+
+  // empty words of a dense other would count as present when growing
+  bitstore tmp;
+  if (other._dense && op(0, ~Word(0))) {
+    tmp = sparse(b);
+    b = tmp;
+  }
+  size_t cnt = 0;
+  bool changed = update(mut(), b, op, count_tracked() ? &cnt : nullptr);
+  if (count_tracked())
+    _count = cnt;
+  if (changed)
+    _hash.store(0);
+  retune();
+  return changed;
+}
+
+/** Updates the dense layout in place, only the words of a compressed other are visited if possible. */
+BITSET_TEMPLATE
+template<typename Op>
+bool BITSET_T::updated_dense(const basic_bitset &other, Op op) {
+  using namespace bitset_detail;
+  assert(_dense);
+  words_t b = other.bits();
+  size_t n1 = bits().size() / (MS + 1);
+  size_t n2 = other._dense ? b.size() / (MS + 1) : meta_words(b);
+
+  // grow if bits only set in other survive op
+  const auto empty_block = [&](size_t m) {
+    if (!other._dense) return !(b[m] & M_DATA_MSK);
+    const Word *e = b.data() + n2 + m * MS;
+    return std::all_of(e, e + MS, [](Word v) { return !v; });
+  };
+  if (n2 > n1 && op(0, ~Word(0))) {
+    size_t n = n2;
+    while (n > n1 && empty_block(n-1)) --n;
+    if (n > n1) {
+      grow_dense(n1, n);
+      n1 = n;
+    }
+  }
+
+  Word *d = mut().data() + n1;
+  const size_t words = n1 * MS;
+  const bool track = count_tracked();
+  Word diff = 0; // differences of all words
+
+  // op(x, 0) == x for all but the intersection: words missing in other stay unchanged
+  const bool keep = op(~Word(0), 0) == Word(~Word(0));
+  if (other._dense || !keep) {
+    // every word is visited, the count and the non-empty words are taken from the result
+    size_t cnt = 0, live = 0;
+    const auto apply = [&](size_t w, Word y) {
+      Word o = d[w];
+      Word v = op(o, y);
+      d[w] = v;
+      diff |= o ^ v;
+      if (track) cnt += count_bits(v);
+      live += v != 0;
+    };
+    if (other._dense) {
+      const size_t k = std::min(n1, n2) * MS;
+      const Word *e = b.data() + n2;
+      for (size_t w = 0; w < k; ++w)
+        apply(w, e[w]);
+      for (size_t w = k; w < words; ++w)
+        apply(w, 0);
+    } else {
+      size_t next = 0;
+      each_word(b, [&](size_t w, Word y) {
+        if (w >= words) return;
+        for (; next < w; ++next)
+          apply(next, 0);
+        apply(w, y);
+        next = w + 1;
+      });
+      for (; next < words; ++next)
+        apply(next, 0);
+    }
+    if (track)
+      _count = cnt;
+    _words = live;
+  } else {
+    // only the words of a compressed other change
+    ptrdiff_t cnt = 0, live = 0;
+    each_word(b, [&](size_t w, Word y) {
+      if (w >= words) return;
+      Word o = d[w];
+      Word v = op(o, y);
+      d[w] = v;
+      diff |= o ^ v;
+      if (track) cnt += ptrdiff_t(count_bits(v)) - ptrdiff_t(count_bits(o));
+      live += ptrdiff_t(v != 0) - ptrdiff_t(o != 0);
+    });
+    if (track)
+      _count += cnt;
+    _words += live;
+  }
+
+  if (diff)
+    _hash.store(0);
+  retune();
+  return diff;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::operator&=(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a & b; };
+  updated(other, o);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::operator|=(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a | b; };
+  updated(other, o);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::operator^=(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a ^ b; };
+  updated(other, o);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::operator-=(const basic_bitset &other) {
+  subtract_with(other);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::union_with(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a | b; };
+  return updated(other, o);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::intersect_with(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a & b; };
+  return updated(other, o);
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::subtract_with(const basic_bitset &other) {
+  const auto o = [](Word a, Word b) -> Word { return a ^ (a & b); };
+  return updated(other, o);
+}
+
+BITSET_TEMPLATE
+typename BITSET_T::patch BITSET_T::diff(const basic_bitset &from, const basic_bitset &to) {
+  using namespace bitset_detail;
+  const bitstore &a = from.bits();
+  const bitstore &b = to.bits();
+  size_t n1 = meta_words(a);
+  size_t n2 = meta_words(b);
+  auto it1 = a.cbegin() + n1;
+  auto it2 = b.cbegin() + n2;
+
+  patch out;
+  out.capacity = std::max(from.capacity(), to.capacity());
+  if (from._store == to._store)
+    return out;
+
+  for (size_t m = 0; m < std::max(n1, n2); ++m) {
+    Word v1 = m < n1 ? a[m] & M_DATA_MSK : 0;
+    Word v2 = m < n2 ? b[m] & M_DATA_MSK : 0;
+    // skip identical blocks without looking at single words
+    size_t k = count_bits(v1);
+    if (v1 == v2 && std::equal(it1, it1 + k, it2)) {
+      it1 += k;
+      it2 += k;
+      continue;
+    }
+
+    size_t p;
+    for (Word u = v1 | v2; first_bit(u, p); u &= u - 1) {
+      Word w1 = get_bit(v1, p) ? *(it1++) : 0;
+      Word w2 = get_bit(v2, p) ? *(it2++) : 0;
+      if (w1 != w2)
+        out.words.emplace_back(m * MS + p, w1 ^ w2);
+    }
+  }
+  return out;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::apply(const patch &p) {
+  using namespace bitset_detail;
+  if (p.capacity > capacity())
+    resize(p.capacity);
+  if (p.words.empty())
+    return;
+
+  // update the existing data words in place
+  bitstore &b = mut();
+  bool rebuild = false;
+  size_t m = 0;
+  size_t n = meta_words(b);
+  size_t d = n;
+  for (const auto &[w, x] : p.words) {
+    assert(w < n * MS);
+    for (; m < w / MS; ++m)
+      d += count_bits(b[m], M_DATA_MSK);
+
+    Word o = 0, v = x;
+    if (get_bit(b[m], w % MS)) {
+      Word &r = b[d + count_bits_lo(b[m], w % MS)];
+      o = r;
+      v = r ^= x;
+    }
+    if (count_tracked())
+      _count += count_bits(v) - (ptrdiff_t) count_bits(o);
+    rehash(w, o, v);
+    if (_dense)
+      _words += (v != 0) - (o != 0);
+    // a data word must be inserted or removed
+    rebuild = rebuild || (!_dense && (!o || !v));
+  }
+
+  if (!rebuild) {
+    if (_dense)
+      retune();
+    return;
+  }
+
+  // insert the new words and drop the empty ones in a single pass
+  builder out(n);
+  auto it = p.words.cbegin();
+  // existing words are already patched, empty ones are skipped by each_word()
+  const auto fresh = [&b](size_t w) { return !get_bit(b[w / MS], w % MS); };
+  each_word(b, [&](size_t w, Word v) {
+    for (; it != p.words.cend() && it->first < w; ++it)
+      if (fresh(it->first)) out.push(it->first, it->second);
+    if (it != p.words.cend() && it->first == w) ++it;
+    out.push(w, v);
+  });
+  for (; it != p.words.cend(); ++it)
+    if (fresh(it->first)) out.push(it->first, it->second);
+  assign(std::move(out.out));
+}
+
+BITSET_TEMPLATE
+std::vector<uint8_t> BITSET_T::patch::serialize() const {
+  std::vector<uint8_t> out;
+  const auto varint = [&out](size_t v) {
+    for (; v >= 0x80; v >>= 7)
+      out.push_back(uint8_t(v) | 0x80);
+    out.push_back(uint8_t(v));
+  };
+
+  varint(capacity);
+  varint(words.size());
+  size_t next = 0;
+  for (const auto &[w, x] : words) {
+    varint(w - next);
+    next = w + 1;
+    for (size_t i = 0; i < sizeof(Word); ++i)
+      out.push_back(uint8_t(uint64_t(x) >> (8 * i)));
+  }
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::patch::deserialize(std::span<const uint8_t> in, patch &out) {
+  size_t pos = 0;
+  const auto varint = [&](size_t &v) {
+    v = 0;
+    for (unsigned s = 0; s < 64; s += 7) {
+      if (pos == in.size()) return false;
+      uint8_t c = in[pos++];
+      v |= size_t(c & 0x7f) << s;
+      if (!(c & 0x80)) return true;
+    }
+    return false;
+  };
+
+  size_t cnt;
+  out.words.clear();
+  if (!varint(out.capacity) || !varint(cnt) || out.capacity % MMS)
+    return false;
+  size_t next = 0;
+  for (size_t k = 0; k < cnt; ++k) {
+    size_t gap;
+    if (!varint(gap) || in.size() - pos < sizeof(Word))
+      return false;
+    size_t w = next + gap;
+    Word x = 0;
+    for (size_t i = 0; i < sizeof(Word); ++i)
+      x |= Word(Word(in[pos++]) << (8 * i));
+    // indices must be ascending and within the capacity, words non-empty
+    if (w < next || w >= out.capacity / BITS || !x)
+      return false;
+    out.words.emplace_back(w, x);
+    next = w + 1;
+  }
+  return pos == in.size();
+}
+
+// Roaring portable format, see https://github.com/RoaringBitmap/RoaringFormatSpec
+namespace bitset_detail::roaring {
+constexpr uint32_t cookie = 12347;          // with run containers, followed by the number of containers - 1
+constexpr uint32_t cookie_no_run = 12346;   // without run containers, followed by the number of containers
+constexpr size_t no_offset_threshold = 4;   // fewer containers with runs have no offset header
+constexpr size_t max_array = 4096;          // larger containers without runs are bitmaps
+constexpr size_t chunk_words = 1024;        // 64 bit words per container
+
+enum class container { array, bitmap, run };
+} // namespace bitset_detail::roaring
+
+BITSET_TEMPLATE
+std::vector<uint8_t> BITSET_T::to_roaring() const {
+  using namespace bitset_detail;
+  using roaring::container;
+
+  struct chunk {
+    uint16_t key;
+    uint32_t card;
+    container type;
+    std::vector<uint8_t> data;
+  };
+  std::vector<chunk> chunks;
+
+  // encode a chunk as the smallest container
+  std::vector<uint64_t> buf(roaring::chunk_words);
+  const auto flush = [&](size_t key) {
+    size_t card = 0, runs = 0;
+    uint64_t carry = 0;
+    for (uint64_t x : buf) {
+      card += count_bits(x);
+      runs += count_bits(x & ~((x << 1) | carry));
+      carry = x >> 63;
+    }
+    size_t plain = card <= roaring::max_array ? 2 * card : 8 * roaring::chunk_words;
+    chunk c{uint16_t(key), uint32_t(card), container::run, {}};
+    if (2 + 4 * runs < plain) {
+      put_le(c.data, runs, 2);
+      for (size_t i = 0; i < roaring::chunk_words * 64;) {
+        // find the next run [i, e)
+        uint64_t x = buf[i / 64] >> (i % 64);
+        if (!x) { i = (i / 64 + 1) * 64; continue; }
+        i += count_zero_r(x);
+        size_t e = i;
+        while (e < roaring::chunk_words * 64) {
+          uint64_t y = ~buf[e / 64] >> (e % 64);
+          if (y) { e += count_zero_r(y); break; }
+          e = (e / 64 + 1) * 64;
+        }
+        put_le(c.data, i, 2);
+        put_le(c.data, e - i - 1, 2);
+        i = e;
+      }
+    } else if (card <= roaring::max_array) {
+      c.type = container::array;
+      size_t p;
+      for (size_t j = 0; j < roaring::chunk_words; ++j)
+        for (uint64_t x = buf[j]; first_bit(x, p); x &= x - 1)
+          put_le(c.data, j * 64 + p, 2);
+    } else {
+      c.type = container::bitmap;
+      for (uint64_t x : buf) put_le(c.data, x, 8);
+    }
+    chunks.push_back(std::move(c));
+    std::fill(buf.begin(), buf.end(), 0);
+  };
+
+  size_t key = SIZE_MAX;
+  bool too_high = false;
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    // the keys have 16 bits, set bits at or beyond 2^32 can't be encoded
+    if (too_high || i >= (size_t(1) << 26)) {
+      too_high = true;
+      return;
+    }
+    if (i / roaring::chunk_words != key) {
+      if (key != SIZE_MAX) flush(key);
+      key = i / roaring::chunk_words;
+    }
+    buf[i % roaring::chunk_words] = x;
+  });
+  if (too_high)
+    return {};
+  if (key != SIZE_MAX) flush(key);
+
+  // headers
+  const size_t n = chunks.size();
+  const bool runs = std::any_of(chunks.begin(), chunks.end(), [](const chunk &c) { return c.type == container::run; });
+  std::vector<uint8_t> out;
+  if (runs) {
+    put_le(out, roaring::cookie | ((n - 1) << 16), 4);
+    std::vector<uint8_t> flags((n + 7) / 8);
+    for (size_t i = 0; i < n; ++i)
+      if (chunks[i].type == container::run) flags[i / 8] |= 1 << (i % 8);
+    out.insert(out.end(), flags.begin(), flags.end());
+  } else {
+    put_le(out, roaring::cookie_no_run, 4);
+    put_le(out, n, 4);
+  }
+  for (const chunk &c : chunks) {
+    put_le(out, c.key, 2);
+    put_le(out, c.card - 1, 2);
+  }
+  if (!runs || n >= roaring::no_offset_threshold) {
+    size_t offset = out.size() + 4 * n;
+    for (const chunk &c : chunks) {
+      put_le(out, offset, 4);
+      offset += c.data.size();
+    }
+  }
+
+  for (const chunk &c : chunks)
+    out.insert(out.end(), c.data.begin(), c.data.end());
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::from_roaring(std::span<const uint8_t> in, basic_bitset &out) {
+  using namespace bitset_detail;
+  using roaring::container;
+  le_reader r{in};
+
+  uint64_t cookie, n;
+  if (!r.read(cookie, 4))
+    return false;
+  const bool runs = (cookie & 0xffff) == roaring::cookie;
+  std::vector<uint8_t> flags;
+  if (runs) {
+    n = (cookie >> 16) + 1;
+    if (r.left() < (n + 7) / 8)
+      return false;
+    flags.assign(in.begin() + r.pos, in.begin() + r.pos + (n + 7) / 8);
+    r.pos += flags.size();
+  } else if (cookie != roaring::cookie_no_run || !r.read(n, 4) || n > 0x10000) {
+    return false;
+  }
+
+  std::vector<std::pair<uint64_t, uint64_t>> headers(n); // key, cardinality
+  for (auto &[key, card] : headers) {
+    if (!r.read(key, 2) || !r.read(card, 2))
+      return false;
+    ++card;
+  }
+  for (size_t i = 1; i < n; ++i)
+    if (headers[i].first <= headers[i-1].first)
+      return false;
+
+  std::vector<uint64_t> offsets;
+  if (!runs || n >= roaring::no_offset_threshold) {
+    offsets.resize(n);
+    for (uint64_t &o : offsets)
+      if (!r.read(o, 4)) return false;
+  }
+
+  size_t size = n ? (headers.back().first + 1) << 16 : 1;
+  builder b(MP(size - 1) + 1);
+  std::vector<uint64_t> buf(roaring::chunk_words);
+  for (size_t i = 0; i < n; ++i) {
+    const auto [key, card] = headers[i];
+    if (!offsets.empty() && offsets[i] != r.pos)
+      return false;
+
+    std::fill(buf.begin(), buf.end(), 0);
+    size_t cnt = 0;
+    uint64_t v, l;
+    if (runs && (flags[i / 8] >> (i % 8)) & 1) {
+      uint64_t k;
+      if (!r.read(k, 2))
+        return false;
+      for (uint64_t next = 0; k; --k) {
+        // runs are ascending, disjoint and end within the chunk
+        if (!r.read(v, 2) || !r.read(l, 2) || v < next || v + l > 0xffff)
+          return false;
+        for (uint64_t e = v + l + 1; v < e; ++v)
+          buf[v / 64] |= uint64_t(1) << (v % 64);
+        cnt += l + 1;
+        next = v;
+      }
+    } else if (card <= roaring::max_array) {
+      for (uint64_t next = 0; cnt < card; ++cnt) {
+        if (!r.read(v, 2) || v < next)
+          return false;
+        buf[v / 64] |= uint64_t(1) << (v % 64);
+        next = v + 1;
+      }
+    } else {
+      for (uint64_t &x : buf) {
+        if (!r.read(x, 8)) return false;
+        cnt += count_bits(x);
+      }
+    }
+    if (cnt != card)
+      return false;
+
+    for (size_t j = 0; j < roaring::chunk_words; ++j)
+      push64(b, key * roaring::chunk_words + j, buf[j]);
+  }
+  if (r.left())
+    return false;
+
+  out = basic_bitset(std::move(b.out), b.cnt);
+  return true;
+}
+
+// EWAH marker word: running bit, 32 bit running length (clean words), 31 bit number of literal words
+namespace bitset_detail::ewah {
+constexpr uint64_t max_run = (uint64_t(1) << 32) - 1;
+constexpr uint64_t max_literals = (uint64_t(1) << 31) - 1;
+
+inline bool run_bit(uint64_t m) { return m & 1; }
+inline uint64_t run_length(uint64_t m) { return (m >> 1) & max_run; }
+inline uint64_t literals(uint64_t m) { return m >> 33; }
+} // namespace bitset_detail::ewah
+
+BITSET_TEMPLATE
+std::vector<uint8_t> BITSET_T::to_ewah() const {
+  using namespace bitset_detail;
+  std::vector<uint64_t> buf{0};
+  size_t rlw = 0; // position of the last marker
+
+  // append n clean words of bit
+  const auto run = [&](bool bit, uint64_t n) {
+    while (n) {
+      uint64_t m = buf[rlw];
+      uint64_t len = ewah::run_length(m);
+      if (ewah::literals(m) || (len && ewah::run_bit(m) != bit) || len == ewah::max_run) {
+        buf.push_back(0);
+        rlw = buf.size() - 1;
+        continue;
+      }
+      uint64_t k = std::min(n, ewah::max_run - len);
+      buf[rlw] = ((len + k) << 1) | bit;
+      n -= k;
+    }
+  };
+  const auto literal = [&](uint64_t x) {
+    if (ewah::literals(buf[rlw]) == ewah::max_literals) {
+      buf.push_back(0);
+      rlw = buf.size() - 1;
+    }
+    buf[rlw] += uint64_t(1) << 33;
+    buf.push_back(x);
+  };
+
+  size_t next = 0, size = 0;
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    run(false, i - next);
+    if (~x) literal(x);
+    else run(true, 1);
+    next = i + 1;
+    size = i * 64 + std::bit_width(x);
+  });
+
+  std::vector<uint8_t> out;
+  put_le(out, size, 8);
+  put_le(out, buf.size(), 8);
+  for (uint64_t x : buf) put_le(out, x, 8);
+  put_le(out, rlw, 8);
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::from_ewah(std::span<const uint8_t> in, basic_bitset &out) {
+  using namespace bitset_detail;
+  le_reader r{in};
+  uint64_t size, n, rlw;
+  if (!r.read(size, 8) || !r.read(n, 8) || r.left() < 8 || r.left() % 8 || n != r.left() / 8 - 1)
+    return false;
+  std::vector<uint64_t> buf(n);
+  for (uint64_t &x : buf) r.read(x, 8);
+  if (!r.read(rlw, 8))
+    return false;
+
+  // count the words before allocating, to_ewah() encodes exactly the
+  // words up to the size and the run lengths must not claim more
+  const uint64_t limit = size / 64 + (size % 64 != 0);
+  uint64_t words = 0;
+  size_t last = 0;
+  for (size_t p = 0; p < n; p += ewah::literals(buf[p]) + 1) {
+    if (ewah::literals(buf[p]) > n - p - 1)
+      return false;
+    words += ewah::run_length(buf[p]) + ewah::literals(buf[p]);
+    if (words > limit)
+      return false;
+    last = p;
+  }
+  if (n && last != rlw)
+    return false;
+  if (words != limit)
+    return false;
+
+  size_t capacity = std::max<uint64_t>(size, 1);
+  builder b(MP(capacity - 1) + 1);
+  size_t i = 0;
+  for (size_t p = 0; p < n;) {
+    uint64_t m = buf[p++];
+    if (ewah::run_bit(m)) {
+      for (uint64_t k = ewah::run_length(m); k; --k)
+        push64(b, i++, ~uint64_t(0));
+    } else {
+      i += ewah::run_length(m);
+    }
+    for (uint64_t k = ewah::literals(m); k; --k)
+      push64(b, i++, buf[p++]);
+  }
+
+  out = basic_bitset(std::move(b.out), b.cnt);
+  return true;
+}
+
+/** Builds a bitstore with a fixed number of metadata words from data words in ascending order. */
+BITSET_TEMPLATE
+struct BITSET_T::builder {
+  explicit builder(size_t cnt_m) : out(cnt_m, M_NEXT_MSK), words(cnt_m * MS) {
+    out.back() = 0;
+  }
+
+  /** Appends the data word with index w (in words), empty words are skipped. */
+  void push(size_t w, Word v) {
+    if (!v) return;
+    assert(w < words);
+    assert(next <= w);
+    bitset_detail::set_bit(out[w / MS], w % MS);
+    out.push_back(v);
+    cnt += bitset_detail::count_bits(v);
+    next = w + 1;
+  }
+
+  bitstore out;
+  size_t words;  // capacity in words
+  size_t cnt{};  // number of set bits
+  size_t next{}; // smallest index of the next data word
+};
+
+/** Calls f(w, v) for each non-empty data word v with its index w (in words) in ascending order. */
+BITSET_TEMPLATE
+template<typename F>
+void BITSET_T::each_word(words_t b, F f) {
+  size_t n = meta_words(b);
+  auto it = b.begin() + n;
+  for (size_t m = 0; m < n; ++m) {
+    size_t p;
+    for (Word v = b[m] & M_DATA_MSK; bitset_detail::first_bit(v, p); v &= v - 1) {
+      // the dense layout stores empty words too
+      if (*it) f(m * MS + p, *it);
+      ++it;
+    }
+  }
+  assert(it == b.end());
+}
+
+BITSET_TEMPLATE
+template<typename F>
+void BITSET_T::each_word64(words_t b, F f) {
+  if constexpr (BITS == 64) {
+    each_word(b, f);
+  } else {
+    // collect consecutive words of the same 64 bit word
+    size_t i = SIZE_MAX;
+    uint64_t x = 0;
+    each_word(b, [&](size_t w, Word v) {
+      if (w * BITS / 64 != i) {
+        if (x) f(i, x);
+        i = w * BITS / 64;
+        x = 0;
+      }
+      x |= uint64_t(v) << (w * BITS % 64);
+    });
+    if (x) f(i, x);
+  }
+}
+
+BITSET_TEMPLATE
+void BITSET_T::push64(builder &out, size_t i, uint64_t x) {
+  for (size_t k = 0; k < 64 / BITS; ++k)
+    out.push(i * (64 / BITS) + k, Word(x >> (k * BITS % 64)));
+}
+
+/**
+ * Translates all bits of b by k positions into a bitstore with cnt_m metadata words.
+ * Bits moved outside of the new capacity are dropped.
+ */
+BITSET_TEMPLATE
+typename BITSET_T::bitstore BITSET_T::translate(const bitstore &b, size_t cnt_m, ptrdiff_t k, size_t *cnt) {
+  builder out(cnt_m);
+  const ptrdiff_t words = cnt_m * MS;
+  // split k into whole words q and a remainder r in [0, BITS)
+  ptrdiff_t q = k / (ptrdiff_t) BITS;
+  unsigned r = k % (ptrdiff_t) BITS;
+  if (k < 0 && r) {
+    --q;
+    r += BITS;
+  }
+  assert(q * (ptrdiff_t) BITS + r == k);
+
+  if (r == 0) {
+    // word granularity, the data words are kept as is
+    each_word(b, [&](size_t w, Word v) {
+      ptrdiff_t t = w + q;
+      if (t >= 0 && t < words) out.push(t, v);
+    });
+  } else {
+    // carry the bits over the word boundaries, merging adjacent contributions
+    ptrdiff_t p_idx = -1;
+    Word p_val = 0;
+    const auto emit = [&](ptrdiff_t t, Word v) {
+      if (t < 0 || t >= words || !v) return;
+      if (t != p_idx) {
+        if (p_idx >= 0) out.push(p_idx, p_val);
+        p_idx = t;
+        p_val = 0;
+      }
+      p_val |= v;
+    };
+    each_word(b, [&](size_t w, Word v) {
+      emit(w + q, Word(v << r));
+      emit(w + q + 1, Word(v >> (BITS - r)));
+    });
+    if (p_idx >= 0) out.push(p_idx, p_val);
+  }
+
+  if (cnt) *cnt = out.cnt;
+  return std::move(out.out);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::shift_left(size_t k) {
+  size_t n = meta_words(bits());
+  size_t cnt = 0;
+  assign(translate(bits(), n, std::min(k, n * MMS), count_tracked() ? &cnt : nullptr));
+  if (count_tracked())
+    _count = cnt;
+  _hash.store(0);
+}
+
+BITSET_TEMPLATE
+void BITSET_T::shift_right(size_t k) {
+  size_t n = meta_words(bits());
+  size_t cnt = 0;
+  assign(translate(bits(), n, -(ptrdiff_t) std::min(k, n * MMS), count_tracked() ? &cnt : nullptr));
+  if (count_tracked())
+    _count = cnt;
+  _hash.store(0);
+}
+
+BITSET_TEMPLATE
+BITSET_T BITSET_T::offset_copy(ptrdiff_t k) const {
+  size_t size = capacity();
+  if (k > 0) size += k;
+  size_t cnt = 0;
+  bitstore out = translate(bits(), MP(size-1) + 1, k, count_tracked() ? &cnt : nullptr);
+  return basic_bitset(std::move(out), count_tracked() ? cnt : untracked, _dense_at);
+}
+
+BITSET_TEMPLATE
+size_t BITSET_T::iterator::operator*() const {
+  assert(_pos_d < BITS);
+  return ((_it_m - _b.bits().cbegin()) * MS + _pos_m) * BITS + _pos_d;
+}
+
+BITSET_TEMPLATE
+void BITSET_T::iterator::next() {
+  using namespace bitset_detail;
+  if (_it_d == _b.bits().cend()) {
+    return;
+  }
+
+  // find the next bit in the data
+  if (next_bit(*_it_d, _pos_d)) {
+    // next bit found
+    return;
+  }
+  skip();
+}
+
+BITSET_TEMPLATE
+void BITSET_T::iterator::skip() {
+  using namespace bitset_detail;
+  do {
+    // no more bits, get the next data byte
+    _it_d++;
+    // no more bytes, we're at the end
+    if (_it_d == _b.bits().cend()) {
+      _pos_d = 0;
+      return;
+    }
+
+    // find the next metadata bit
+    if (!next_bit(Word(*_it_m & M_DATA_MSK), _pos_m)) {
+      // next metadata word
+      do {
+        assert(*_it_m & M_NEXT_MSK);
+        _it_m++;
+      } while (!first_bit(Word(*_it_m & M_DATA_MSK), _pos_m));
+    }
+    // the dense layout stores empty words too
+  } while (!first_bit(*_it_d, _pos_d));
+}
+
+BITSET_TEMPLATE
+typename BITSET_T::iterator& BITSET_T::iterator::operator++() {
+  next();
+  return *this;
+}
+
+BITSET_TEMPLATE
+typename BITSET_T::iterator BITSET_T::iterator::operator++(int) {
+  auto o = *this;
+  next();
+  return o;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::iterator::operator==(const iterator &other) const {
+  assert(std::addressof(other._b) == std::addressof(_b));
+  return _it_d == other._it_d && _pos_d == other._pos_d;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::iterator::operator!=(const iterator &other) const {
+  return !(*this == other);
+}
+
+BITSET_TEMPLATE
+BITSET_T::iterator::iterator(const basic_bitset &bs) : _b(bs) { }
+
+BITSET_TEMPLATE
+typename BITSET_T::iterator BITSET_T::iterator::begin(const basic_bitset &bs) {
+  using namespace bitset_detail;
+  iterator it(bs);
+  // set the iterator and skip metadata for data
+  it._it_d = bs.bits().cbegin();
+  while(*(it._it_d++) & M_NEXT_MSK);
+
+  if (it._it_d == bs.bits().cend()) {
+    // we're empty
+    assert(bs.empty());
+    it._it_m = bs.bits().cend();
+    it._pos_m = it._pos_d = 0;
+  } else {
+    // find the first element
+    it._it_m = bs.bits().cbegin();
+    assert(*it._it_m); // either set of the next bit is set
+    for (; !(*it._it_m & M_DATA_MSK); ++it._it_m);
+    bool f_m = first_bit(*it._it_m, it._pos_m);
+    assert(f_m); (void)f_m;
+    if (!first_bit(*it._it_d, it._pos_d))
+      it.skip();
+  }
+  return it;
+}
+
+BITSET_TEMPLATE
+typename BITSET_T::iterator BITSET_T::iterator::end(const basic_bitset &bs) {
+  iterator it(bs);
+  it._it_d = bs.bits().cend();
+  it._it_m = bs.bits().cend();
+  it._pos_d = 0;
+  it._pos_m = 0;
+  return it;
+}
+
+BITSET_TEMPLATE
+std::string BITSET_T::to_string() const {
+  size_t end = 0;
+  each_word(bits(), [&](size_t w, Word) { end = (w + 1) * BITS; });
+
+  // bit i is at i + i / 8, write the zeros and spaces first and then the set bits
+  std::string out(end ? end + (end - 1) / 8 : 0, '0');
+  for (size_t p = 8; p < out.size(); p += 9)
+    out[p] = ' ';
+  each_word(bits(), [&](size_t w, Word v) {
+    size_t p;
+    for (; bitset_detail::first_bit(v, p); v &= v - 1) {
+      size_t i = w * BITS + p;
+      out[i + i / 8] = '1';
+    }
+  });
+  if (end < capacity())
+    out += end ? " ..." : "...";
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::from_string(std::string_view in, basic_bitset &out) {
+  if (in.ends_with("..."))
+    in.remove_suffix(3);
+
+  // pack the digits into dense words, then compress them in one pass
+  std::vector<uint64_t> words(in.size() / 64 + 1);
+  size_t i = 0;
+  for (char c : in) {
+    if (c == ' ') continue;
+    uint64_t d = uint64_t(c - '0');
+    if (d > 1) return false;
+    words[i / 64] |= d << (i % 64);
+    ++i;
+  }
+  words.resize((i + 63) / 64);
+  basic_bitset b = from_words(words.data(), words.size());
+  if (i && b.capacity() != MMS * (MP(i - 1) + 1))
+    b.resize(i);
+  out = std::move(b);
+  return true;
+}
+
+BITSET_TEMPLATE
+std::string BITSET_T::to_hex() const {
+  static constexpr char digit[] = "0123456789abcdef";
+  size_t size = 0;
+  each_word64(bits(), [&](size_t i, uint64_t x) { size = i * 64 + std::bit_width(x); });
+  if (!size)
+    return "0";
+
+  // the highest digit comes first
+  const size_t n = (size + 3) / 4;
+  std::string out(n, '0');
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    for (size_t k = 0; k < 16 && i * 16 + k < n; ++k)
+      out[n - 1 - (i * 16 + k)] = digit[(x >> (4 * k)) & 0xf];
+  });
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::from_hex(std::string_view in, basic_bitset &out) {
+  if (in.starts_with("0x") || in.starts_with("0X"))
+    in.remove_prefix(2);
+  const auto value = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  if (in.empty() || !std::all_of(in.begin(), in.end(), [&](char c) { return value(c) >= 0; }))
+    return false;
+
+  // 16 digits per 64 bit word, starting with the lowest digit at the end
+  builder b(MP(in.size() * 4 - 1) + 1);
+  for (size_t i = 0; i * 16 < in.size(); ++i) {
+    uint64_t x = 0;
+    for (size_t k = 0; k < 16 && i * 16 + k < in.size(); ++k)
+      x |= uint64_t(value(in[in.size() - 1 - (i * 16 + k)])) << (4 * k);
+    push64(b, i, x);
+  }
+  out = basic_bitset(std::move(b.out), b.cnt);
+  return true;
+}
+
+BITSET_TEMPLATE
+std::string BITSET_T::to_ranges() const {
+  using bitset_detail::count_zero_r;
+  std::string out;
+  size_t first = npos, last = 0; // the open run [first, last)
+  const auto flush = [&] {
+    if (first == npos) return;
+    if (!out.empty()) out += ',';
+    out += std::to_string(first);
+    if (last - first > 1) out += '-' + std::to_string(last - 1);
+  };
+
+  each_word64(bits(), [&](size_t i, uint64_t x) {
+    for (size_t p = 0; p < 64 && (x >> p);) {
+      size_t a = p + count_zero_r(x >> p);
+      size_t e = a + count_zero_r(~x >> a);
+      if (first == npos || last != i * 64 + a) {
+        flush();
+        first = i * 64 + a;
+      }
+      last = i * 64 + std::min<size_t>(e, 64);
+      p = e;
+    }
+  });
+  flush();
+  return out;
+}
+
+BITSET_TEMPLATE
+bool BITSET_T::from_ranges(std::string_view in, basic_bitset &out) {
+  // parse and validate all ranges before anything is allocated
+  std::vector<std::pair<size_t, size_t>> ranges;
+  const char *p = in.data(), *end = in.data() + in.size();
+  while (p != end) {
+    if (!ranges.empty() && *(p++) != ',')
+      return false;
+    size_t a, b;
+    auto r = std::from_chars(p, end, a);
+    if (r.ec != std::errc())
+      return false;
+    b = a;
+    if (r.ptr != end && *r.ptr == '-') {
+      r = std::from_chars(r.ptr + 1, end, b);
+      if (r.ec != std::errc() || b < a)
+        return false;
+    }
+    if (b == SIZE_MAX || (!ranges.empty() && a <= ranges.back().second))
+      return false;
+    ranges.emplace_back(a, b);
+    p = r.ptr;
+  }
+
+  builder bld(ranges.empty() ? 1 : MP(ranges.back().second) + 1);
+  size_t w = 0;
+  Word v = 0;
+  for (auto [a, b] : ranges) {
+    for (size_t x = a / BITS; x <= b / BITS; ++x) {
+      if (x != w) {
+        bld.push(w, v);
+        w = x;
+        v = 0;
+      }
+      size_t lo = x == a / BITS ? a % BITS : 0;
+      size_t hi = x == b / BITS ? b % BITS + 1 : BITS;
+      v |= bitset_detail::msk_lo<Word>(hi) & ~bitset_detail::msk_lo<Word>(lo);
+    }
+  }
+  bld.push(w, v);
+  out = basic_bitset(std::move(bld.out), bld.cnt);
+  return true;
+}
+
+#undef BITSET_T
+#undef BITSET_TEMPLATE
+
+#endif //BITSET_IMPL_HPP
@@ -0,0 +1,272 @@
+#ifndef BITSET_JOIN_HPP
+#define BITSET_JOIN_HPP
+
+#include "bitset.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief All-pairs similarity and containment joins of two bitset collections.
+ * @details Both collections are sorted by cardinality, so the candidates of a
+ * bitset are a contiguous range of the other collection. The pairs are
+ * walked in tiles of a few bitsets of each side, so a tile of the right side
+ * is reused for a whole tile of the left side while it is in cache. The
+ * tiles of the left side are distributed over the worker threads.
+ *
+ * A candidate pair is first checked by cardinality, then by a bound from
+ * the metadata words and the cardinality of each metadata block. The data
+ * words are walked block by block and the walk stops as soon as the bound
+ * of the remaining blocks can't reach the threshold.
+ */
+template<typename Word = uint64_t, unsigned FanOut = sizeof(Word) * CHAR_BIT - 1>
+class basic_bitset_join {
+public:
+  using bitset_type = basic_bitset<Word, FanOut>;
+
+  /** A pair of positions in the left and the right collection. */
+  struct match {
+    size_t left;
+    size_t right;
+    double similarity; // Jaccard similarity |a & b| / |a | b|
+
+    bool operator==(const match &other) const = default;
+  };
+
+  /**
+   * @param threads number of worker threads, 0 uses the hardware concurrency
+   * @param tile number of bitsets per tile
+   */
+  explicit basic_bitset_join(unsigned threads = 0, size_t tile = 64);
+
+  /**
+   * @brief Finds all pairs with a Jaccard similarity of at least threshold.
+   * @details The threshold must be in (0, 1], two empty sets have similarity 1.
+   * The matches are ordered by left and right position.
+   */
+  std::vector<match> similar(std::span<const bitset_type> left, std::span<const bitset_type> right, double threshold) const;
+
+  /**
+   * @brief Finds all pairs with left[i] <= right[j].
+   * @details The similarity of such a pair is |left[i]| / |right[j]|.
+   * The matches are ordered by left and right position.
+   */
+  std::vector<match> contained(std::span<const bitset_type> left, std::span<const bitset_type> right) const;
+
+private:
+  using words_t = typename bitset_type::words_t;
+
+  struct item {
+    size_t idx;
+    size_t cnt;
+    words_t words;
+    std::span<const uint32_t> blocks; // set bits per metadata block
+  };
+
+  struct side {
+    std::vector<item> items; // sorted by cardinality
+    std::vector<uint32_t> blocks;
+  };
+
+  static side prepare(std::span<const bitset_type> s);
+  /**
+   * Counts the common bits of a and b in inter if there are at least need,
+   * returns false as soon as fewer are possible.
+   */
+  static bool intersect(const item &a, const item &b, size_t need, size_t &inter);
+  static double jaccard(size_t inter, size_t uni) { return uni ? double(inter) / double(uni) : 1.0; }
+
+  /**
+   * Calls test(a, b, similarity) for all pairs with a cardinality of b in
+   * range(|a|) and collects the accepted ones.
+   */
+  template<typename Range, typename Test>
+  std::vector<match> join(std::span<const bitset_type> left, std::span<const bitset_type> right, Range range, Test test) const;
+
+  unsigned _threads;
+  size_t _tile;
+};
+
+using bitset_join = basic_bitset_join<>;
+
+template<typename Word, unsigned FanOut>
+basic_bitset_join<Word, FanOut>::basic_bitset_join(unsigned threads, size_t tile)
+    : _threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())), _tile(std::max<size_t>(tile, 1)) { }
+
+template<typename Word, unsigned FanOut>
+std::vector<typename basic_bitset_join<Word, FanOut>::match>
+basic_bitset_join<Word, FanOut>::similar(std::span<const bitset_type> left, std::span<const bitset_type> right, double threshold) const {
+  assert(threshold > 0 && threshold <= 1);
+  // |a & b| <= min(|a|, |b|) and |a | b| >= max(|a|, |b|)
+  const auto range = [threshold](size_t c) {
+    return std::pair<size_t, size_t>(std::floor(c * threshold), std::ceil(c / threshold));
+  };
+  const auto test = [threshold](const item &a, const item &b, double &s) {
+    const size_t sum = a.cnt + b.cnt;
+    // the similarity grows with the intersection, find the smallest one reaching the threshold
+    const size_t bound = std::min(a.cnt, b.cnt);
+    size_t need = std::min<size_t>(std::floor(threshold * sum / (1 + threshold)), bound);
+    while (need > 0 && jaccard(need - 1, sum - need + 1) >= threshold) --need;
+    while (need <= bound && jaccard(need, sum - need) < threshold) ++need;
+    size_t inter;
+    if (need > bound || !intersect(a, b, need, inter))
+      return false;
+    s = jaccard(inter, sum - inter);
+    return true;
+  };
+  return join(left, right, range, test);
+}
+
+template<typename Word, unsigned FanOut>
+std::vector<typename basic_bitset_join<Word, FanOut>::match>
+basic_bitset_join<Word, FanOut>::contained(std::span<const bitset_type> left, std::span<const bitset_type> right) const {
+  const auto range = [](size_t c) {
+    return std::pair<size_t, size_t>(c, SIZE_MAX);
+  };
+  const auto test = [](const item &a, const item &b, double &s) {
+    // subset_check() compares the metadata before the data
+    if (!bitset_type::subset_check(a.words, b.words, false))
+      return false;
+    s = jaccard(a.cnt, b.cnt);
+    return true;
+  };
+  return join(left, right, range, test);
+}
+
+template<typename Word, unsigned FanOut>
+template<typename Range, typename Test>
+std::vector<typename basic_bitset_join<Word, FanOut>::match>
+basic_bitset_join<Word, FanOut>::join(std::span<const bitset_type> left, std::span<const bitset_type> right, Range range, Test test) const {
+  const side ls = prepare(left);
+  const side rs = prepare(right);
+  const std::vector<item> &l = ls.items;
+  const std::vector<item> &r = rs.items;
+  const size_t tiles = (l.size() + _tile - 1) / _tile;
+
+  // first candidate with a cardinality of at least c, or after the last one with at most c
+  const auto lower = [&r](size_t c) {
+    return std::partition_point(r.begin(), r.end(), [c](const item &i) { return i.cnt < c; }) - r.begin();
+  };
+  const auto upper = [&r](size_t c) {
+    return std::partition_point(r.begin(), r.end(), [c](const item &i) { return i.cnt <= c; }) - r.begin();
+  };
+
+  std::atomic<size_t> next{0};
+  const auto work = [&](std::vector<match> &out) {
+    for (size_t t; (t = next.fetch_add(1, std::memory_order_relaxed)) < tiles;) {
+      const size_t l0 = t * _tile;
+      const size_t l1 = std::min(l0 + _tile, l.size());
+      // the candidates of the tile, l is sorted by cardinality
+      const size_t r0 = lower(range(l[l0].cnt).first);
+      const size_t r1 = upper(range(l[l1-1].cnt).second);
+
+      for (size_t t0 = r0; t0 < r1; t0 += _tile) {
+        const size_t t1 = std::min(t0 + _tile, r1);
+        for (size_t i = l0; i < l1; ++i) {
+          const auto [lo, hi] = range(l[i].cnt);
+          for (size_t j = t0; j < t1; ++j) {
+            if (r[j].cnt < lo || r[j].cnt > hi)
+              continue;
+            double s;
+            if (test(l[i], r[j], s))
+              out.push_back(match{l[i].idx, r[j].idx, s});
+          }
+        }
+      }
+    }
+  };
+
+  const size_t n = std::min<size_t>(_threads, tiles);
+  std::vector<std::vector<match>> found(std::max<size_t>(n, 1));
+  if (n <= 1) {
+    work(found[0]);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; ++i)
+      threads.emplace_back(work, std::ref(found[i]));
+    for (auto &th : threads)
+      th.join();
+  }
+
+  std::vector<match> out;
+  for (auto &f : found)
+    out.insert(out.end(), f.begin(), f.end());
+  std::sort(out.begin(), out.end(), [](const match &a, const match &b) {
+    return a.left != b.left ? a.left < b.left : a.right < b.right;
+  });
+  return out;
+}
+
+template<typename Word, unsigned FanOut>
+typename basic_bitset_join<Word, FanOut>::side basic_bitset_join<Word, FanOut>::prepare(std::span<const bitset_type> s) {
+  side out;
+  std::vector<size_t> offset;
+  for (const bitset_type &b : s) {
+    words_t w = b.bits();
+    size_t n = bitset_type::meta_words(w);
+    offset.push_back(out.blocks.size());
+    auto it = w.begin() + n;
+    for (size_t m = 0; m < n; ++m) {
+      uint32_t cnt = 0;
+      for (size_t k = bitset_detail::count_bits(w[m], bitset_type::M_DATA_MSK); k; --k)
+        cnt += bitset_detail::count_bits(*(it++));
+      out.blocks.push_back(cnt);
+    }
+  }
+
+  out.items.reserve(s.size());
+  for (size_t i = 0; i < s.size(); ++i) {
+    words_t w = s[i].bits();
+    std::span<const uint32_t> blocks(out.blocks.data() + offset[i], bitset_type::meta_words(w));
+    out.items.push_back(item{i, s[i].count(), w, blocks});
+  }
+  std::stable_sort(out.items.begin(), out.items.end(), [](const item &a, const item &b) { return a.cnt < b.cnt; });
+  return out;
+}
+
+template<typename Word, unsigned FanOut>
+bool basic_bitset_join<Word, FanOut>::intersect(const item &a, const item &b, size_t need, size_t &inter) {
+  using namespace bitset_detail;
+  constexpr Word M_DATA_MSK = bitset_type::M_DATA_MSK;
+  const size_t n = std::min(a.blocks.size(), b.blocks.size());
+
+  // bound of the common bits of each block, from the metadata and the block cardinalities
+  const auto bound = [&](size_t m) -> size_t {
+    size_t words = count_bits(a.words[m], b.words[m] & M_DATA_MSK);
+    return std::min<size_t>({a.blocks[m], b.blocks[m], words * bitset_type::word_bits});
+  };
+  size_t rest = 0;
+  for (size_t m = 0; m < n; ++m)
+    rest += bound(m);
+  if (rest < need)
+    return false;
+
+  // walk the data like combine(), but only the words present in both
+  auto it1 = a.words.begin() + a.blocks.size();
+  auto it2 = b.words.begin() + b.blocks.size();
+  size_t cnt = 0;
+  for (size_t m = 0; m < n; ++m) {
+    Word v1 = a.words[m] & M_DATA_MSK;
+    Word v2 = b.words[m] & M_DATA_MSK;
+    size_t p;
+    for (Word c = v1 & v2; first_bit(c, p); c &= c - 1)
+      cnt += count_bits(it1[count_bits_lo(v1, p)], it2[count_bits_lo(v2, p)]);
+    it1 += count_bits(v1);
+    it2 += count_bits(v2);
+
+    rest -= bound(m);
+    if (cnt + rest < need)
+      return false;
+  }
+  inter = cnt;
+  return true;
+}
+
+#endif //BITSET_JOIN_HPP
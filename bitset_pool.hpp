@@ -0,0 +1,182 @@
+#ifndef BITSET_POOL_HPP
+#define BITSET_POOL_HPP
+
+#include "bitset.hpp"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @brief Hash-consing pool for bitsets.
+ * @details Interned bitsets are stored once in shared, immutable, reference
+ * counted storage. Equal bitsets of the same capacity interned in the same
+ * pool get the same handle, so equality of handles is a pointer comparison.
+ * Bitsets that are equal but differ in capacity get different handles, so
+ * different handles don't imply different bitsets. The results of
+ * operations on handles are memoized per operand pair, the memo keeps at
+ * most a fixed number of results and evicts the least recently used one.
+ *
+ * The pool only holds weak references to the interned bitsets, a bitset is
+ * released once its last handle (or memo entry) is gone.
+ * The pool is not thread-safe.
+ */
+template<typename Word = uint64_t, unsigned FanOut = sizeof(Word) * CHAR_BIT - 1>
+class basic_bitset_pool {
+public:
+  using bitset_type = basic_bitset<Word, FanOut>;
+
+  /** Binary operations on handles. */
+  enum class op { intersect, unite, symmetric_difference, difference };
+
+  /** Shared handle to an interned bitset. */
+  class handle {
+  public:
+    handle() = default;
+
+    const bitset_type &operator*() const { return *_p; }
+    const bitset_type *operator->() const { return _p.get(); }
+    const bitset_type *get() const { return _p.get(); }
+
+    bool operator==(const handle &other) const { return _p == other._p; }
+    bool operator!=(const handle &other) const { return _p != other._p; }
+
+  private:
+    friend basic_bitset_pool;
+    explicit handle(std::shared_ptr<const bitset_type> p) : _p(std::move(p)) { }
+
+    std::shared_ptr<const bitset_type> _p;
+  };
+
+  /** @param memo_capacity maximal number of memoized operation results */
+  explicit basic_bitset_pool(size_t memo_capacity = 4096) : _memo_capacity(memo_capacity) { }
+
+  /**
+   * @brief Interns b.
+   * @return the handle of an equal bitset with the same capacity if one is
+   * already interned
+   */
+  handle intern(bitset_type b);
+
+  /** Applies o to a and b, the result is interned and memoized. */
+  handle apply(op o, const handle &a, const handle &b);
+
+  /** Counts the interned bitsets that are still referenced. */
+  size_t size() const;
+
+  /** Drops all memoized results. */
+  void clear_memo() { _memo.clear(); _lru.clear(); }
+
+private:
+  struct memo_key {
+    op o;
+    const bitset_type *a;
+    const bitset_type *b;
+
+    bool operator==(const memo_key &other) const = default;
+  };
+
+  struct memo_hash {
+    size_t operator()(const memo_key &k) const noexcept {
+      size_t h = std::hash<const void *>()(k.a);
+      h = h * 31 + std::hash<const void *>()(k.b);
+      return h * 31 + static_cast<size_t>(k.o);
+    }
+  };
+
+  struct memo_entry {
+    memo_key key;
+    handle a, b; // keep the operands alive while their key is in use
+    handle result;
+  };
+
+  /** Removes the expired entries of the table. */
+  void sweep();
+
+  // interned bitsets by their hash and capacity
+  std::unordered_multimap<size_t, std::weak_ptr<const bitset_type>> _table;
+  size_t _sweep_at{64}; // table size triggering the next sweep
+
+  // memoized results, most recently used first
+  std::list<memo_entry> _lru;
+  std::unordered_map<memo_key, typename std::list<memo_entry>::iterator, memo_hash> _memo;
+  size_t _memo_capacity;
+};
+
+using bitset_pool = basic_bitset_pool<>;
+
+template<typename Word, unsigned FanOut>
+typename basic_bitset_pool<Word, FanOut>::handle basic_bitset_pool<Word, FanOut>::intern(bitset_type b) {
+  // the capacity is part of the key, a handle must accept every index valid for b
+  const size_t h = b.hash() * 31 + b.capacity();
+  auto [first, last] = _table.equal_range(h);
+  for (auto it = first; it != last;) {
+    if (auto p = it->second.lock()) {
+      if (p->capacity() == b.capacity() && *p == b) return handle(std::move(p));
+      ++it;
+    } else {
+      it = _table.erase(it);
+    }
+  }
+
+  auto p = std::make_shared<const bitset_type>(std::move(b));
+  _table.emplace(h, p);
+  if (_table.size() >= _sweep_at) {
+    sweep();
+    _sweep_at = std::max<size_t>(64, 2 * _table.size());
+  }
+  return handle(std::move(p));
+}
+
+template<typename Word, unsigned FanOut>
+typename basic_bitset_pool<Word, FanOut>::handle basic_bitset_pool<Word, FanOut>::apply(op o, const handle &a, const handle &b) {
+  memo_key key{o, a.get(), b.get()};
+  // all but the difference are commutative
+  if (o != op::difference && std::less<const void *>()(key.b, key.a))
+    std::swap(key.a, key.b);
+
+  if (auto it = _memo.find(key); it != _memo.end()) {
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return it->second->result;
+  }
+
+  bitset_type r;
+  switch (o) {
+    case op::intersect: r = *a & *b; break;
+    case op::unite: r = *a | *b; break;
+    case op::symmetric_difference: r = *a ^ *b; break;
+    case op::difference: r = *a - *b; break;
+  }
+  handle result = intern(std::move(r));
+
+  if (_memo_capacity == 0)
+    return result;
+  if (_memo.size() >= _memo_capacity) {
+    _memo.erase(_lru.back().key);
+    _lru.pop_back();
+  }
+  _lru.push_front(memo_entry{key, a, b, result});
+  _memo.emplace(key, _lru.begin());
+  return result;
+}
+
+template<typename Word, unsigned FanOut>
+size_t basic_bitset_pool<Word, FanOut>::size() const {
+  size_t cnt = 0;
+  for (const auto &e : _table)
+    cnt += !e.second.expired();
+  return cnt;
+}
+
+template<typename Word, unsigned FanOut>
+void basic_bitset_pool<Word, FanOut>::sweep() {
+  for (auto it = _table.begin(); it != _table.end();) {
+    if (it->second.expired())
+      it = _table.erase(it);
+    else
+      ++it;
+  }
+}
+
+#endif //BITSET_POOL_HPP
@@ -1,11 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+
 #include "../bitset.hpp"
 
 #include <bitset>
 #include <cassert>
+#include <cstdlib>
 #include <ostream>
+#include <vector>
+
+/** One bool per bit of the capacity. */
+using reference = std::vector<bool>;
+
+/** Sets each of the first size bits with density percent, ref gets the same bits. */
+inline bitset random_bitset(size_t size, unsigned density, reference &ref,
+                            float threshold = bitset::default_dense_threshold) {
+  bitset b(size);
+  b.dense_threshold(threshold);
+  ref.assign(b.capacity(), false);
+  for (size_t i = 0; i < size; ++i) {
+    if (random() % 100 < density) {
+      b.set(i, true);
+      ref[i] = true;
+    }
+  }
+  return b;
+}
+
+/** Compares the bits, the count and the iteration of b with ref. */
+inline void require_equal(const bitset &b, const reference &ref) {
+  size_t cnt = 0;
+  for (size_t i = 0; i < ref.size(); ++i) {
+    REQUIRE(b.get(i) == ref[i]);
+    cnt += ref[i];
+  }
+  REQUIRE(b.count() == cnt);
+  REQUIRE(b.empty() == (cnt == 0));
+
+  std::vector<size_t> seen;
+  for (auto it = b.cbegin(); it != b.cend(); ++it) seen.push_back(*it);
+  REQUIRE(seen.size() == cnt);
+  for (size_t i : seen) REQUIRE((i < ref.size() && ref[i]));
+}
 
-template<size_t I>
-static bool operator==(const bitset &b, const std::bitset<I> &r) {
+template<typename W, unsigned F, size_t I>
+static bool operator==(const basic_bitset<W, F> &b, const std::bitset<I> &r) {
   assert(b.capacity() >= I);
 
   for (int i = 0; i < I; ++i) {
@@ -15,7 +53,8 @@ static bool operator==(const bitset &b, const std::bitset<I> &r) {
   return true;
 }
 
-static std::ostream& operator<<(std::ostream& os, const bitset& b) {
+template<typename W, unsigned F>
+static std::ostream& operator<<(std::ostream& os, const basic_bitset<W, F>& b) {
   for (int i = 0; i < b.capacity(); ++i) {
     os << (b[i] ? '1' : '0');
   }
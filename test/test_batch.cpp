@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+#include "helper.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <vector>
+
+TEST_CASE("get many") {
+  const size_t MAX = 3 * 4032;
+  const size_t RND = GENERATE(0, 10, 1000, 5000);
+
+  bitset b(MAX);
+  std::bitset<MAX> r;
+  for (int i = 0; i < RND; ++i) {
+    unsigned p = random() % MAX;
+    b.set(p, true);
+    r.set(p, true);
+  }
+
+  std::vector<size_t> idx(2000);
+  for (auto &i : idx) i = random() % MAX;
+  std::sort(idx.begin(), idx.end());
+  idx.push_back(MAX - 1);
+
+  std::unique_ptr<bool[]> out(new bool[idx.size()]);
+  b.get_many(idx, std::span<bool>(out.get(), idx.size()));
+  for (size_t i = 0; i < idx.size(); ++i)
+    REQUIRE(out[i] == r[idx[i]]);
+}
+
+TEST_CASE("set many") {
+  const size_t MAX = 3 * 4032;
+  const size_t RND = GENERATE(0, 10, 1000, 5000);
+  const size_t CNT = GENERATE(1, 10, 2000);
+
+  bitset b(MAX);
+  std::bitset<MAX> r;
+  for (int i = 0; i < RND; ++i) {
+    unsigned p = random() % MAX;
+    b.set(p, true);
+    r.set(p, true);
+  }
+
+  for (bool value : {true, false, true}) {
+    std::vector<size_t> idx(CNT);
+    for (auto &i : idx) i = random() % MAX;
+    std::sort(idx.begin(), idx.end());
+
+    b.set_many(idx, value);
+    for (size_t i : idx) r.set(i, value);
+
+    REQUIRE(b == r);
+    REQUIRE(b.count() == r.count());
+  }
+
+  // the layout must be canonical
+  bitset c(MAX);
+  for (size_t i = 0; i < MAX; ++i)
+    if (r[i]) c.set(i, true);
+  REQUIRE(b == c);
+}
+
+TEST_CASE("set many in place") {
+  bitset b(4032);
+  b.set(0, true);
+  b.set(100, true);
+
+  std::vector<size_t> idx = {1, 2, 101};
+  b.set_many(idx, true);
+  REQUIRE(b.count() == 5);
+
+  idx = {0, 1, 2};
+  b.set_many(idx, false);
+  REQUIRE(b.count() == 2);
+  REQUIRE(b.get(100));
+  REQUIRE(b.get(101));
+  REQUIRE(b == (bitset(4032) | b));
+}
+
+TEST_CASE("from unsorted") {
+  const size_t SZE = GENERATE(1, 100, 20000);
+  const unsigned threads = GENERATE(1, 3, 8);
+
+  std::vector<size_t> idx(3 * SZE / 2);
+  for (auto &i : idx) i = random() % SZE;
+
+  bitset ref(SZE);
+  for (size_t i : idx) ref.set(i, true);
+
+  bitset b = bitset::from_unsorted(idx, SZE, threads);
+  REQUIRE(b == ref);
+  REQUIRE(b.capacity() == ref.capacity());
+  REQUIRE(b.count() == ref.count());
+  REQUIRE(b.hash() == ref.hash());
+
+  // merge another batch
+  std::vector<size_t> more(SZE / 3);
+  for (auto &i : more) i = random() % SZE;
+  for (size_t i : more) ref.set(i, true);
+  b.append_unsorted(more, threads);
+  REQUIRE(b == ref);
+  REQUIRE(b.count() == ref.count());
+
+  REQUIRE(bitset::from_unsorted({}, SZE, threads).empty());
+}
+
+TEST_CASE("from unsorted with narrow words") {
+  using small = basic_bitset<uint16_t, 5>;
+  const size_t SZE = 1000;
+  std::vector<size_t> idx(500);
+  for (auto &i : idx) i = random() % SZE;
+
+  small ref(SZE);
+  for (size_t i : idx) ref.set(i, true);
+  REQUIRE(small::from_unsorted(idx, SZE, 4) == ref);
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../bitset.hpp"
+
+#include <thread>
+#include <vector>
+
+static bitset filled() {
+  bitset b(3 * 4032);
+  for (size_t i = 0; i < b.capacity(); i += 5)
+    b.set(i, true);
+  return b;
+}
+
+TEST_CASE("copies share the storage") {
+  bitset a = filled();
+  bitset b = a;
+  REQUIRE(b.shares(a));
+  REQUIRE(b == a);
+
+  // reads and no-op writes don't detach
+  REQUIRE(b.get(5));
+  b.set(5, true);
+  b.set(6, false);
+  b.resize(b.capacity());
+  std::vector<size_t> set_idx = {0, 5, 4030}, clear_idx = {1, 6, 4031};
+  b.set_many(set_idx, true);
+  b.set_many(clear_idx, false);
+  REQUIRE(b.shares(a));
+
+  b.set(6, true);
+  REQUIRE_FALSE(b.shares(a));
+  REQUIRE(b.get(6));
+  REQUIRE_FALSE(a.get(6));
+  REQUIRE(b.count() == a.count() + 1);
+}
+
+TEST_CASE("all modifications detach") {
+  const bitset ref = filled();
+  bitset o(3 * 4032);
+  o.set(1, true);
+
+  std::vector<bitset> v(8, ref);
+  v[0].clear();
+  v[1].resize(5 * 4032);
+  v[2] |= o;
+  v[3] &= o;
+  v[4] ^= o;
+  v[5].shift_left(3);
+  v[6].shift_right(3);
+  std::vector<size_t> idx = {1, 2, 3};
+  v[7].set_many(idx, true);
+
+  for (auto &b : v)
+    REQUIRE_FALSE(b.shares(ref));
+  REQUIRE(v[1].capacity() == 5 * 4032);
+  REQUIRE(ref.capacity() == 3 * 4032);
+  REQUIRE(ref == filled());
+  REQUIRE(ref.count() == filled().count());
+}
+
+TEST_CASE("snapshots can be read by other threads") {
+  bitset a = filled();
+  const size_t cnt = a.count();
+
+  std::vector<std::thread> workers;
+  std::vector<size_t> seen(4);
+  for (size_t t = 0; t < seen.size(); ++t) {
+    workers.emplace_back([snapshot = a, &seen, t] {
+      size_t c = 0;
+      for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it) ++c;
+      seen[t] = c;
+    });
+  }
+  // modify the original while the snapshots are read
+  for (size_t i = 0; i < a.capacity(); i += 3)
+    a.set(i, false);
+  for (auto &w : workers) w.join();
+
+  for (size_t c : seen)
+    REQUIRE(c == cnt);
+}
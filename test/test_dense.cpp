@@ -0,0 +1,232 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "helper.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// the largest single allocation while watched
+static std::atomic<bool> watch{false};
+static std::atomic<size_t> largest{0};
+
+void *operator new(size_t n) {
+  if (watch.load(std::memory_order_relaxed) && n > largest.load(std::memory_order_relaxed))
+    largest.store(n, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t n) { return operator new(n); }
+void *operator new(size_t n, const std::nothrow_t &) noexcept { return std::malloc(n ? n : 1); }
+void *operator new[](size_t n, const std::nothrow_t &) noexcept { return std::malloc(n ? n : 1); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+/** Runs f and returns the largest allocation it made. */
+template<typename F>
+static size_t largest_allocation(F f) {
+  largest = 0;
+  watch = true;
+  f();
+  watch = false;
+  return largest;
+}
+
+TEST_CASE("dense: switch with hysteresis") {
+  const size_t SZE = 4032 * 4;
+  bitset b(SZE);
+  REQUIRE_FALSE(b.dense());
+
+  // one bit per data word, dense from 3/4 of the words on
+  const size_t words = b.capacity() / bitset::word_bits;
+  for (size_t w = 0; w < words; ++w) {
+    b.set(w * bitset::word_bits, true);
+    REQUIRE(b.dense() == (w + 1 >= 0.75 * words));
+  }
+  REQUIRE(b.count() == words);
+
+  // and compressed again below 3/8
+  for (size_t w = 0; w < words; ++w) {
+    b.set(w * bitset::word_bits, false);
+    REQUIRE(b.dense() == (words - w - 1 >= 0.375 * words));
+  }
+  REQUIRE(b.empty());
+  REQUIRE(b.count() == 0);
+  REQUIRE(b.hash() == bitset(SZE).hash());
+
+  // the threshold can force or disable the layout
+  b.dense_threshold(0);
+  REQUIRE(b.dense());
+  b.set(7, true);
+  REQUIRE(b.dense());
+  REQUIRE(b.get(7));
+  b.dense_threshold(2);
+  REQUIRE_FALSE(b.dense());
+  REQUIRE(b.get(7));
+  REQUIRE(b.count() == 1);
+}
+
+TEST_CASE("dense: operations with mixed layouts") {
+  const auto [t1, t2] = GENERATE(std::pair<float, float>{0, 0}, std::pair<float, float>{0, 2},
+                                 std::pair<float, float>{2, 0}, std::pair<float, float>{0.5f, 0.5f});
+  const size_t s1 = GENERATE(100, 9000);
+  const size_t s2 = GENERATE(100, 9000);
+  const unsigned d1 = GENERATE(1, 60);
+  const unsigned d2 = 61 - d1;
+
+  reference r1, r2;
+  bitset a = random_bitset(s1, d1, r1, t1);
+  bitset b = random_bitset(s2, d2, r2, t2);
+  const size_t cap = std::max(r1.size(), r2.size());
+  r1.resize(cap);
+  r2.resize(cap);
+
+  const auto check = [&](auto f, const bitset &res, bool in_place) {
+    reference r(cap);
+    for (size_t i = 0; i < cap; ++i) r[i] = f(r1[i], r2[i]);
+    if (in_place) r.resize(res.capacity());
+    else REQUIRE(res.capacity() == cap);
+    require_equal(res, r);
+    // the hash and the comparison don't depend on the layout
+    bitset c = res;
+    c.dense_threshold(c.dense() ? 2 : 0);
+    REQUIRE(c.dense() != res.dense());
+    REQUIRE(c == res);
+    REQUIRE(c.hash() == res.hash());
+    REQUIRE(c <= res);
+    REQUIRE_FALSE(c < res);
+  };
+
+  check([](bool x, bool y) { return x && y; }, a & b, false);
+  check([](bool x, bool y) { return x || y; }, a | b, false);
+  check([](bool x, bool y) { return x != y; }, a ^ b, false);
+  check([](bool x, bool y) { return x && !y; }, a - b, false);
+
+  bitset c = a;
+  REQUIRE(c.union_with(b) == !(b <= a));
+  check([](bool x, bool y) { return x || y; }, c, true);
+  REQUIRE_FALSE(c.union_with(b));
+  REQUIRE(a <= c);
+  REQUIRE(b <= c);
+
+  c = a;
+  c &= b;
+  check([](bool x, bool y) { return x && y; }, c, true);
+  REQUIRE(c <= a);
+  c = a;
+  c ^= b;
+  check([](bool x, bool y) { return x != y; }, c, true);
+  c = a;
+  REQUIRE(c.subtract_with(b) == !(a & b).empty());
+  check([](bool x, bool y) { return x && !y; }, c, true);
+  REQUIRE(a == a);
+  REQUIRE((a == b) == (r1 == r2));
+}
+
+TEST_CASE("dense: resize, compact and clear") {
+  bitset b(4032);
+  b.dense_threshold(0);
+  b.set(5, true);
+  b.set(4000, true);
+  REQUIRE(b.dense());
+
+  b.resize(3 * 4032);
+  REQUIRE(b.capacity() == 3 * 4032);
+  b.set(3 * 4032 - 1, true);
+  REQUIRE(b.count() == 3);
+  b.resize(4032);
+  REQUIRE(b.capacity() == 4032);
+  REQUIRE(b.count() == 2);
+  REQUIRE(b.get(4000));
+
+  b.resize(3 * 4032);
+  b.compact();
+  REQUIRE(b.capacity() == 4032);
+  REQUIRE(b.count() == 2);
+  REQUIRE(b.dense());
+
+  b.clear();
+  REQUIRE(b.empty());
+  REQUIRE(b.count() == 0);
+  REQUIRE(b.capacity() == 4032);
+  REQUIRE(b.dense());
+
+  // compact() keeps a full bitset dense
+  bitset f(4032);
+  for (size_t i = 0; i < 4032; ++i)
+    f.set(i, true);
+  REQUIRE(f.dense());
+  f.compact();
+  REQUIRE(f.dense());
+  REQUIRE(f.count() == 4032);
+}
+
+TEST_CASE("dense: copies stay independent") {
+  reference ref;
+  bitset a = random_bitset(3 * 4032, 90, ref);
+  REQUIRE(a.dense());
+  bitset b = a;
+  REQUIRE(b.shares(a));
+  b.set(17, !b.get(17));
+  REQUIRE_FALSE(b.shares(a));
+  require_equal(a, ref);
+  REQUIRE(b != a);
+  REQUIRE(b.dense_threshold() == a.dense_threshold());
+
+  // the results inherit the threshold of the left operand
+  bitset s(3 * 4032);
+  s.dense_threshold(2);
+  REQUIRE_FALSE((s | a).dense());
+  REQUIRE((a | s).dense());
+  REQUIRE(s.offset_copy(3).dense_threshold() == 2);
+  REQUIRE(a.offset_copy(-3).dense());
+}
+
+TEST_CASE("dense: large sparse and small dense operands") {
+  // 20000 blocks: 160 KB compressed metadata, 10 MB of dense words
+  const size_t SZE = 4032 * 20000;
+  const size_t limit = 1 << 20;
+  bitset big(SZE);
+  for (size_t i = 0; i < SZE; i += 4032 * 10)
+    big.set(i + 7, true);
+  bitset small(4032);
+  for (size_t i = 0; i < 4032; ++i)
+    small.set(i, true);
+  REQUIRE_FALSE(big.dense());
+  REQUIRE(small.dense());
+  const size_t cnt = big.count();
+
+  // the sparse receiver isn't switched for a few dense words
+  bitset u = big;
+  REQUIRE(largest_allocation([&] { u |= small; }) < limit);
+  REQUIRE_FALSE(u.dense());
+  REQUIRE(u.count() == cnt + 4032 - 1);
+  REQUIRE(largest_allocation([&] { u ^= small; }) < limit);
+  REQUIRE(u.count() == cnt - 1);
+
+  // the dense receiver switches before growing
+  bitset v = small;
+  REQUIRE(largest_allocation([&] { v |= big; }) < limit);
+  REQUIRE_FALSE(v.dense());
+  REQUIRE(v.count() == cnt + 4032 - 1);
+  REQUIRE(largest_allocation([&] { REQUIRE((small & big).count() == 1); }) < limit);
+  REQUIRE(largest_allocation([&] { REQUIRE((small | big) == v); }) < limit);
+
+  bitset r = small;
+  REQUIRE(largest_allocation([&] { r.resize(SZE); }) < limit);
+  REQUIRE_FALSE(r.dense());
+  REQUIRE(r.capacity() == SZE);
+  REQUIRE(r.count() == 4032);
+
+  // a dense receiver that stays dense grows in place
+  bitset d = small;
+  d.resize(2 * 4032);
+  REQUIRE(d.dense());
+}
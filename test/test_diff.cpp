@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+
+static bitset modified(const bitset &b, size_t changes, size_t size) {
+  bitset out = b;
+  out.resize(size);
+  for (size_t i = 0; i < changes; ++i) {
+    size_t p = random() % size;
+    out.set(p, !out.get(p));
+  }
+  return out;
+}
+
+TEST_CASE("diff: apply") {
+  const size_t SZE = 20000;
+  const size_t changes = GENERATE(0, 1, 10, 1000, 20000);
+
+  bitset a(SZE);
+  for (int i = 0; i < 3000; ++i) a.set(random() % SZE, true);
+  bitset b = modified(a, changes, SZE);
+
+  bitset::patch p = bitset::diff(a, b);
+  REQUIRE(p.words.size() <= changes);
+  REQUIRE(p.capacity == a.capacity());
+
+  bitset c = a;
+  c.apply(p);
+  REQUIRE(c == b);
+  REQUIRE(c.count() == b.count());
+  REQUIRE(c.hash() == b.hash());
+
+  // patching back and forth
+  c.apply(bitset::diff(b, a));
+  REQUIRE(c == a);
+  REQUIRE(c.count() == a.count());
+}
+
+TEST_CASE("diff: identical") {
+  bitset a(20000);
+  for (int i = 0; i < 3000; ++i) a.set(random() % 20000, true);
+  bitset b = a;
+  REQUIRE(bitset::diff(a, b).words.empty());
+  b.set(0, !b.get(0));
+  b.set(0, !b.get(0));
+  REQUIRE(bitset::diff(a, b).words.empty());
+}
+
+TEST_CASE("diff: different capacities") {
+  bitset a(100), b(20000);
+  a.set(5, true);
+  b.set(5, true);
+  b.set(19000, true);
+
+  bitset::patch p = bitset::diff(a, b);
+  REQUIRE(p.words.size() == 1);
+  bitset c = a;
+  c.apply(p);
+  REQUIRE(c == b);
+  REQUIRE(c.capacity() == b.capacity());
+
+  bitset d = b;
+  d.apply(bitset::diff(b, a));
+  REQUIRE(d == a);
+  REQUIRE(d.count() == 1);
+}
+
+TEST_CASE("diff: apply keeps a larger capacity") {
+  bitset from(100), to(100);
+  to.set(7, true);
+
+  bitset big(50000);
+  const size_t cap = big.capacity();
+  big.set(49000, true);
+  big.apply(bitset::diff(from, to));
+  REQUIRE(big.capacity() == cap);
+  REQUIRE(big.get(7));
+  REQUIRE(big.get(49000));
+  REQUIRE(big.count() == 2);
+
+  bitset empty(50000);
+  empty.apply(bitset::diff(from, from));
+  REQUIRE(empty.capacity() == cap);
+  empty.set(49999, true);
+  REQUIRE(empty.get(49999));
+}
+
+TEST_CASE("diff: serialize") {
+  const size_t SZE = 1000000;
+  bitset a(SZE);
+  for (int i = 0; i < 30000; ++i) a.set(random() % SZE, true);
+  bitset b = modified(a, 20, SZE);
+
+  bitset::patch p = bitset::diff(a, b);
+  std::vector<uint8_t> bytes = p.serialize();
+  // a few bytes per changed word
+  REQUIRE(bytes.size() <= 4 + p.words.size() * (sizeof(uint64_t) + 3));
+
+  bitset::patch q;
+  REQUIRE(bitset::patch::deserialize(bytes, q));
+  REQUIRE(q == p);
+  bitset c = a;
+  c.apply(q);
+  REQUIRE(c == b);
+
+  // truncated or trailing input
+  for (size_t n = 0; n < bytes.size(); ++n)
+    REQUIRE_FALSE(bitset::patch::deserialize(std::span(bytes.data(), n), q));
+  bytes.push_back(0);
+  REQUIRE_FALSE(bitset::patch::deserialize(bytes, q));
+
+  // out of range
+  bitset::patch r;
+  r.capacity = bitset::block_bits;
+  r.words.emplace_back(bitset::fan_out, 1);
+  REQUIRE_FALSE(bitset::patch::deserialize(r.serialize(), q));
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+
+#include "../bitset.hpp"
+#include "helper.hpp"
+
+#include <bitset>
+
+TEMPLATE_TEST_CASE("geometry", "", (basic_bitset<uint8_t>), (basic_bitset<uint16_t, 5>),
+                   (basic_bitset<uint32_t>), (basic_bitset<uint64_t, 7>), bitset) {
+  const size_t MAX = 3000;
+  const size_t RND = 1000;
+
+  TestType b1(MAX), b2(MAX);
+  std::bitset<MAX> r1, r2;
+
+  REQUIRE(b1.capacity() % TestType::block_bits == 0);
+  REQUIRE(b1.capacity() >= MAX);
+
+  for (int i = 0; i < RND; ++i) {
+    unsigned r = random() % MAX;
+    bool val = random() % 4;
+    b1.set(r, val);
+    r1.set(r, val);
+    r = random() % MAX;
+    b2.set(r, true);
+    r2.set(r, true);
+  }
+
+  REQUIRE(b1 == r1);
+  REQUIRE(b1.count() == r1.count());
+  REQUIRE((b1 & b2) == (r1 & r2));
+  REQUIRE((b1 | b2) == (r1 | r2));
+  REQUIRE((b1 ^ b2) == (r1 ^ r2));
+  REQUIRE((b1 - b2) == (r1 & ~r2));
+  REQUIRE((b1 << 77) == (r1 << 77));
+  REQUIRE((b1 & b2) <= b1);
+
+  TestType a = b1;
+  a |= b2;
+  REQUIRE(a == (r1 | r2));
+  a ^= b1;
+  REQUIRE(a == (r2 & ~r1));
+
+  size_t cnt = 0;
+  for (auto it = b1.cbegin(); it != b1.cend(); ++it, ++cnt)
+    REQUIRE(r1[*it]);
+  REQUIRE(cnt == r1.count());
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+TEST_CASE("hash follows equality") {
+  const size_t MAX = 3 * 4032;
+  const size_t RND = GENERATE(0, 10, 1000);
+
+  bitset a(MAX), b(4032);
+  std::vector<size_t> pos(RND);
+  for (auto &p : pos) p = random() % 4032;
+
+  for (size_t p : pos) a.set(p, true);
+  for (auto it = pos.rbegin(); it != pos.rend(); ++it) b.set(*it, true);
+
+  // different capacity and order of insertion
+  REQUIRE(a == b);
+  REQUIRE(a.hash() == b.hash());
+  REQUIRE(std::hash<bitset>()(a) == std::hash<bitset>()(b));
+
+  bitset c(MAX);
+  for (size_t p : pos) c.set(p, true);
+  c.set(MAX - 1, true);
+  REQUIRE(c.hash() != a.hash());
+  REQUIRE(c != a);
+  c.set(MAX - 1, false);
+  REQUIRE(c.hash() == a.hash());
+  REQUIRE(c == a);
+}
+
+TEST_CASE("hash cache is kept up to date") {
+  bitset a(2 * 4032), b(2 * 4032);
+  size_t empty = a.hash();
+  REQUIRE(empty == bitset().hash());
+
+  a.set(5, true);
+  size_t h = a.hash();
+  REQUIRE(h != empty);
+
+  // incremental through set()
+  a.set(5000, true);
+  a.set(6, true);
+  a.set(6, false);
+  b.set(5000, true);
+  b |= a;
+  REQUIRE(a.hash() == b.hash());
+
+  // invalidated by the other modifications
+  b.shift_left(1);
+  b.shift_right(1);
+  REQUIRE(a.hash() == b.hash());
+  b ^= a;
+  REQUIRE(b.hash() == empty);
+  a.clear();
+  REQUIRE(a.hash() == empty);
+}
+
+TEST_CASE("bitsets as map keys") {
+  std::unordered_map<bitset, int> m;
+  bitset a(100), b(100);
+  a.set(1, true);
+  b.set(2, true);
+  m[a] = 1;
+  m[b] = 2;
+  m[a | b] = 3;
+
+  bitset c(8000);
+  c.set(1, true);
+  REQUIRE(m.at(c) == 1);
+  c.set(2, true);
+  REQUIRE(m.at(c) == 3);
+  REQUIRE(m.size() == 3);
+}
@@ -80,6 +80,69 @@ TEST_CASE("resize") {
   REQUIRE(b.capacity() == 2*4032);
 }
 
+TEST_CASE("resize down") {
+  bitset a(3 * 4032);
+  for (size_t i = 0; i < a.capacity(); i += 7)
+    a.set(i, true);
+  size_t h = a.hash();
+
+  // within the last block nothing changes
+  a.resize(2 * 4032 + 1);
+  REQUIRE(a.capacity() == 3 * 4032);
+  REQUIRE(a.hash() == h);
+
+  a.resize(4032 + 100);
+  REQUIRE(a.capacity() == 2 * 4032);
+  size_t cnt = 0;
+  for (size_t i = 0; i < a.capacity(); ++i) {
+    REQUIRE(a.get(i) == (i % 7 == 0));
+    cnt += i % 7 == 0;
+  }
+  REQUIRE(a.count() == cnt);
+
+  bitset ref(2 * 4032);
+  for (size_t i = 0; i < ref.capacity(); i += 7)
+    ref.set(i, true);
+  REQUIRE(a == ref);
+  REQUIRE(a.hash() == ref.hash());
+
+  a.resize(0);
+  REQUIRE(a.capacity() == 4032);
+  REQUIRE(a.count() == (4032 - 1) / 7 + 1);
+  a.set(4031, true);
+
+  // a copy keeps its bits
+  bitset b(3 * 4032);
+  b.set(3 * 4032 - 1, true);
+  bitset c = b;
+  c.resize(1);
+  REQUIRE(c.empty());
+  REQUIRE(b.get(3 * 4032 - 1));
+}
+
+TEST_CASE("compact") {
+  bitset a(5 * 4032);
+  for (size_t i = 0; i < a.capacity(); ++i)
+    a.set(i, true);
+  for (size_t i = 4032 + 10; i < a.capacity(); ++i)
+    a.set(i, false);
+  size_t h = a.hash();
+
+  a.shrink_to_fit();
+  REQUIRE(a.capacity() == 5 * 4032);
+
+  a.compact();
+  REQUIRE(a.capacity() == 2 * 4032);
+  REQUIRE(a.count() == 4032 + 10);
+  REQUIRE(a.hash() == h);
+  REQUIRE(a.get(4032 + 9));
+
+  a.clear();
+  a.compact();
+  REQUIRE(a.capacity() == 4032);
+  REQUIRE(a.empty());
+}
+
 TEST_CASE("Counter with three metadata blocks") {
   bitset a(8065);
   a.set(3928, true);
@@ -93,4 +156,127 @@ TEST_CASE("Counter with three metadata blocks") {
   REQUIRE(a.count() == 0);
   a.set(253, true);
   REQUIRE(a.count() == 1);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Counter through operators") {
+  const size_t CNT = 2000;
+  const size_t SZE = 8065;
+
+  bitset a(SZE), b(SZE), u(SZE);
+  u.track_count(false);
+  REQUIRE(a.count_tracked());
+  REQUIRE_FALSE(u.count_tracked());
+
+  for (int i = 0; i < CNT; ++i) {
+    unsigned r = random();
+    unsigned p = random() % SZE;
+    a.set(p, r & 0x1);
+    b.set(p, r & 0x2);
+    u.set(p, r & 0x1);
+  }
+
+  REQUIRE(a.count() == u.count());
+
+  bitset c = a & b;
+  bitset d = a | b;
+  bitset e = a ^ b;
+  bitset f = a - b;
+  REQUIRE(c.count_tracked());
+  REQUIRE_FALSE((u | b).count_tracked());
+
+  c.track_count(false);
+  d.track_count(false);
+  e.track_count(false);
+  f.track_count(false);
+
+  REQUIRE((a & b).count() == c.count());
+  REQUIRE((a | b).count() == d.count());
+  REQUIRE((a ^ b).count() == e.count());
+  REQUIRE((a - b).count() == f.count());
+
+  bitset g = a;
+  g |= b;
+  REQUIRE(g.count() == d.count());
+  g &= b;
+  REQUIRE(g.count() == b.count());
+  g ^= a;
+  g.track_count(false);
+  size_t ref = g.count();
+  g.track_count(true);
+  REQUIRE(g.count() == ref);
+}
+
+TEST_CASE("inplace: minus") {
+  const size_t CNT = 2000;
+  const size_t SZE = 4000;
+
+  bitset a(SZE), b(SZE);
+
+  for (int i = 0; i < CNT; ++i) {
+    unsigned r = random();
+    if (r & 0x1) a.set(i, true);
+    if (r & 0x2) b.set(i, true);
+  }
+
+  bitset ref = a - b;
+  a -= b;
+  REQUIRE(a == ref);
+  REQUIRE(a.count() == ref.count());
+}
+
+TEST_CASE("inplace: report changes") {
+  const size_t CNT = 2000;
+  const size_t SZE = 8065;
+
+  bitset a(SZE), b(SZE);
+
+  for (int i = 0; i < CNT; ++i) {
+    unsigned r = random();
+    unsigned p = random() % SZE;
+    a.set(p, r & 0x1);
+    b.set(p, r & 0x2);
+  }
+
+  bitset c = a;
+  REQUIRE(c.union_with(b) == (a != (a | b)));
+  REQUIRE(c == (a | b));
+  REQUIRE_FALSE(c.union_with(b));
+  REQUIRE_FALSE(c.union_with(a));
+
+  c = a;
+  REQUIRE(c.intersect_with(b) == (a != (a & b)));
+  REQUIRE(c == (a & b));
+  REQUIRE_FALSE(c.intersect_with(b));
+  REQUIRE_FALSE(c.intersect_with(a));
+
+  c = a;
+  REQUIRE(c.subtract_with(b) == (a != (a - b)));
+  REQUIRE(c == (a - b));
+  REQUIRE_FALSE(c.subtract_with(b));
+
+  // the hash follows the changes
+  c = a;
+  size_t h = c.hash();
+  REQUIRE_FALSE(c.union_with(bitset(10)));
+  REQUIRE(c.hash() == h);
+  bitset d(SZE);
+  d.set(SZE - 1, !a.get(SZE - 1));
+  REQUIRE(c.union_with(d) == !a.get(SZE - 1));
+  REQUIRE(c.hash() == (a | d).hash());
+}
+
+TEST_CASE("inplace: report changes across capacities") {
+  bitset a(100), b(10000);
+  b.set(9000, true);
+  REQUIRE(a.union_with(b));
+  REQUIRE(a.get(9000));
+  REQUIRE_FALSE(a.union_with(b));
+
+  bitset c(100), d(10000);
+  c.set(5, true);
+  d.set(9000, true);
+  REQUIRE_FALSE(c.subtract_with(d));
+  REQUIRE(c.capacity() == 4032);
+  REQUIRE(c.intersect_with(bitset(10)));
+  REQUIRE(c.empty());
+}
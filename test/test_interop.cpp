@@ -0,0 +1,271 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// the reference files in test/data are written by hand after the format specifications
+static std::vector<uint8_t> load(const std::string &name) {
+  std::ifstream in(std::string(BITSET_TEST_DATA) + "/" + name, std::ios::binary);
+  REQUIRE(in.good());
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+static std::vector<size_t> positions(const bitset &b) {
+  std::vector<size_t> out;
+  for (auto it = b.cbegin(); it != b.cend(); ++it) out.push_back(*it);
+  return out;
+}
+
+static std::vector<size_t> range(size_t from, size_t to, size_t step = 1) {
+  std::vector<size_t> out;
+  for (size_t i = from; i < to; i += step) out.push_back(i);
+  return out;
+}
+
+static std::vector<size_t> concat(std::initializer_list<std::vector<size_t>> parts) {
+  std::vector<size_t> out;
+  for (const auto &p : parts) out.insert(out.end(), p.begin(), p.end());
+  return out;
+}
+
+TEST_CASE("roaring: reference files") {
+  const std::vector<std::pair<std::string, std::vector<size_t>>> files = {
+      {"roaring_array.bin", {1, 5, 1000, 131072, 196607}},
+      {"roaring_bitmap.bin", concat({{7}, range(65536, 65536 + 10000, 2)})},
+      {"roaring_run.bin", concat({range(10, 1010), {65539}, range(327680, 327780), range(327880, 327980)})},
+      {"roaring_run_offsets.bin", concat({range(0, 65536), range(65537, 65537 + 20000, 2), {196609, 196610, 196611}, range(458852, 463752)})}};
+
+  for (const auto &[name, expected] : files) {
+    std::vector<uint8_t> bytes = load(name);
+    bitset b;
+    REQUIRE(bitset::from_roaring(bytes, b));
+    REQUIRE(positions(b) == expected);
+    REQUIRE(b.count() == expected.size());
+
+    // the smallest containers are chosen, like the reference
+    REQUIRE(b.to_roaring() == bytes);
+  }
+}
+
+TEST_CASE("roaring: round trip") {
+  bitset b(3000000);
+  for (size_t i = 0; i < 20000; ++i) b.set(random() % 3000000, true);
+  for (size_t i = 1000000; i < 1200000; ++i) b.set(i, true);
+  for (size_t i = 2000000; i < 2100000; i += 3) b.set(i, true);
+
+  bitset c;
+  REQUIRE(bitset::from_roaring(b.to_roaring(), c));
+  REQUIRE(c == b);
+  REQUIRE(c.count() == b.count());
+
+  bitset e;
+  REQUIRE(bitset::from_roaring(bitset().to_roaring(), e));
+  REQUIRE(e.empty());
+}
+
+TEST_CASE("roaring: bits beyond 2^32") {
+  const size_t limit = size_t(1) << 32;
+  bitset b(limit + 1);
+  b.set(limit - 1, true);
+  bitset c;
+  REQUIRE(bitset::from_roaring(b.to_roaring(), c));
+  REQUIRE(c == b);
+
+  b.set(limit, true);
+  REQUIRE(b.to_roaring().empty());
+}
+
+TEST_CASE("roaring: malformed input") {
+  std::vector<uint8_t> bytes = load("roaring_run_offsets.bin");
+  bitset b(100);
+  b.set(1, true);
+  for (size_t n = 0; n < bytes.size(); n += 7)
+    REQUIRE_FALSE(bitset::from_roaring(std::span(bytes.data(), n), b));
+  bytes.push_back(0);
+  REQUIRE_FALSE(bitset::from_roaring(bytes, b));
+
+  // unknown cookie
+  std::vector<uint8_t> other = load("roaring_array.bin");
+  other[0] ^= 1;
+  REQUIRE_FALSE(bitset::from_roaring(other, b));
+
+  // unsorted array
+  other = load("roaring_array.bin");
+  std::rotate(other.end() - 4, other.end() - 2, other.end());
+  REQUIRE_FALSE(bitset::from_roaring(other, b));
+
+  // out is unchanged on failure
+  REQUIRE(positions(b) == std::vector<size_t>{1});
+}
+
+TEST_CASE("roaring: narrow words") {
+  basic_bitset<uint16_t, 5> b(200000);
+  for (size_t i = 0; i < 2000; ++i) b.set(random() % 200000, true);
+  for (size_t i = 70000; i < 75000; ++i) b.set(i, true);
+
+  basic_bitset<uint16_t, 5> c;
+  REQUIRE(basic_bitset<uint16_t, 5>::from_roaring(b.to_roaring(), c));
+  REQUIRE(c == b);
+
+  bitset d;
+  REQUIRE(bitset::from_roaring(b.to_roaring(), d));
+  REQUIRE(d.to_roaring() == b.to_roaring());
+}
+
+TEST_CASE("ewah: reference file") {
+  std::vector<uint8_t> bytes = load("ewah.bin");
+  bitset b;
+  REQUIRE(bitset::from_ewah(bytes, b));
+  REQUIRE(positions(b) == concat({{0, 1, 197}, range(320, 512), {6463}}));
+  REQUIRE(b.to_ewah() == bytes);
+}
+
+TEST_CASE("ewah: round trip") {
+  bitset b(3000000);
+  for (size_t i = 0; i < 20000; ++i) b.set(random() % 3000000, true);
+  for (size_t i = 1000000; i < 1200000; ++i) b.set(i, true);
+
+  bitset c;
+  REQUIRE(bitset::from_ewah(b.to_ewah(), c));
+  REQUIRE(c == b);
+  REQUIRE(c.count() == b.count());
+
+  basic_bitset<uint8_t> n(5000), m;
+  for (size_t i = 0; i < 500; ++i) n.set(random() % 5000, true);
+  REQUIRE(basic_bitset<uint8_t>::from_ewah(n.to_ewah(), m));
+  REQUIRE(m == n);
+
+  bitset e;
+  REQUIRE(bitset::from_ewah(bitset().to_ewah(), e));
+  REQUIRE(e.empty());
+}
+
+TEST_CASE("ewah: malformed input") {
+  std::vector<uint8_t> bytes = load("ewah.bin");
+  bitset b;
+  for (size_t n = 0; n < bytes.size(); ++n)
+    REQUIRE_FALSE(bitset::from_ewah(std::span(bytes.data(), n), b));
+
+  // literal words beyond the buffer
+  bytes[16 + 8 * 6 + 4] = 0x10;
+  REQUIRE_FALSE(bitset::from_ewah(bytes, b));
+
+  // a size beyond the encoded words
+  std::vector<uint8_t> huge(32);
+  huge[7] = 0x40;
+  huge[8] = 1;
+  REQUIRE_FALSE(bitset::from_ewah(huge, b));
+  huge[7] = 0;
+  huge[0] = 65;
+  REQUIRE_FALSE(bitset::from_ewah(huge, b));
+
+  // run lengths beyond the size
+  std::vector<uint8_t> runs(32);
+  runs[0] = 64;
+  runs[8] = 1;
+  runs[16] = 0xff;
+  runs[17] = runs[18] = runs[19] = 0xff;
+  runs[20] = 0x01;
+  REQUIRE_FALSE(bitset::from_ewah(runs, b));
+  runs[17] = runs[18] = runs[19] = runs[20] = 0;
+  runs[16] = 0x03;
+  REQUIRE(bitset::from_ewah(runs, b));
+  REQUIRE(b.count() == 64);
+}
+
+TEST_CASE("words: dense words") {
+  const size_t n = GENERATE(0, 1, 3, 70, 1000);
+  const unsigned density = GENERATE(0, 1, 50, 100);
+
+  // runs of zero words of any length between the set words
+  std::vector<uint64_t> words(n);
+  for (auto &w : words)
+    if (random() % 100 < density) w = random() % 3 ? uint64_t(random()) << 32 | random() : ~uint64_t(0);
+
+  bitset b = bitset::from_words(words.data(), n);
+  REQUIRE(b.capacity() >= n * 64);
+  size_t cnt = 0;
+  for (size_t i = 0; i < n * 64; ++i) {
+    REQUIRE(b.get(i) == bool(words[i / 64] >> (i % 64) & 1));
+    cnt += b.get(i);
+  }
+  REQUIRE(b.count() == cnt);
+  REQUIRE(b.hash() == bitset::from_unsorted(positions(b), b.capacity()).hash());
+
+  std::vector<uint64_t> out((b.capacity() + 63) / 64, 42);
+  b.to_words(out.data());
+  REQUIRE(std::equal(words.begin(), words.end(), out.begin()));
+  REQUIRE(std::all_of(out.begin() + n, out.end(), [](uint64_t w) { return w == 0; }));
+}
+
+TEST_CASE("words: narrow words") {
+  using small = basic_bitset<uint16_t, 5>;
+  std::vector<uint64_t> words = {0, 0x8000000000000001, 0, 0, 0, 0x00ff00000000ff00, 0};
+  small b = small::from_words(words.data(), words.size());
+  REQUIRE(b.count() == 2 + 16);
+  REQUIRE(b.get(64));
+  REQUIRE(b.get(127));
+  REQUIRE(b.get(5 * 64 + 8));
+  REQUIRE_FALSE(b.get(5 * 64 + 16));
+
+  std::vector<uint64_t> out((b.capacity() + 63) / 64);
+  b.to_words(out.data());
+  REQUIRE(std::equal(words.begin(), words.end(), out.begin()));
+}
+
+TEST_CASE("words: std::bitset and vector<bool>") {
+  std::bitset<1000> ref;
+  std::vector<bool> bools(1000);
+  for (int i = 0; i < 300; ++i) {
+    size_t p = random() % 1000;
+    ref.set(p);
+    bools[p] = true;
+  }
+
+  bitset b = bitset::from_bitset(ref);
+  REQUIRE(b.capacity() >= 1000);
+  REQUIRE(b.count() == ref.count());
+  REQUIRE(b.to_bitset<1000>() == ref);
+  REQUIRE(bitset::from_bools(bools) == b);
+
+  std::vector<bool> back = b.to_bools();
+  REQUIRE(back.size() == b.capacity());
+  REQUIRE(std::equal(bools.begin(), bools.end(), back.begin()));
+
+  // bits beyond N are dropped
+  b.set(999, true);
+  std::bitset<999> low = b.to_bitset<999>();
+  REQUIRE(low.count() + 1 == b.count());
+  for (size_t i = 0; i < 999; ++i) REQUIRE(low[i] == ref[i]);
+  REQUIRE(bitset::from_bitset(std::bitset<0>()).empty());
+}
+
+TEST_CASE("words: to_bitset against get") {
+  const unsigned density = GENERATE(0, 3, 50, 100);
+  bitset b(5000);
+  basic_bitset<uint16_t, 5> n(5000);
+  for (size_t i = 0; i < 5000; ++i) {
+    if (random() % 100 < density) {
+      b.set(i, true);
+      n.set(i, true);
+    }
+  }
+
+  const std::bitset<4097> r = b.to_bitset<4097>();
+  const std::bitset<4097> s = n.to_bitset<4097>();
+  size_t cnt = 0;
+  for (size_t i = 0; i < 4097; ++i) {
+    REQUIRE(r[i] == b.get(i));
+    REQUIRE(s[i] == n.get(i));
+    cnt += b.get(i);
+  }
+  REQUIRE(r.count() == cnt);
+  REQUIRE(s.count() == cnt);
+}
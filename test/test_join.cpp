@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset_join.hpp"
+
+#include <vector>
+
+static std::vector<bitset> random_sets(size_t n, size_t size) {
+  // clusters of similar sets with varying density
+  std::vector<bitset> out;
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 4 && !out.empty()) {
+      bitset b = out.back();
+      for (int k = 0; k < 5; ++k) b.set(random() % size, random() % 2);
+      out.push_back(b);
+      continue;
+    }
+    bitset b(size);
+    size_t cnt = random() % 200;
+    for (size_t k = 0; k < cnt; ++k) b.set(random() % size, true);
+    out.push_back(b);
+  }
+  return out;
+}
+
+TEST_CASE("join: similarity") {
+  const double threshold = GENERATE(0.3, 0.8, 1.0);
+  const unsigned threads = GENERATE(1, 4);
+  std::vector<bitset> a = random_sets(150, 9000);
+  std::vector<bitset> b = random_sets(120, 5000);
+  a.push_back(bitset(100));
+  b.push_back(bitset(9000));
+  b.push_back(a[7]);
+
+  std::vector<bitset_join::match> ref;
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (size_t j = 0; j < b.size(); ++j) {
+      size_t inter = (a[i] & b[j]).count();
+      size_t uni = (a[i] | b[j]).count();
+      double s = uni ? double(inter) / double(uni) : 1.0;
+      if (s >= threshold) ref.push_back({i, j, s});
+    }
+  }
+
+  bitset_join join(threads, 16);
+  REQUIRE(join.similar(a, b, threshold) == ref);
+}
+
+TEST_CASE("join: containment") {
+  const unsigned threads = GENERATE(1, 4);
+  std::vector<bitset> a = random_sets(100, 5000);
+  std::vector<bitset> b = random_sets(100, 9000);
+  for (size_t i = 0; i < 20; ++i) {
+    bitset c = a[random() % a.size()];
+    c.resize(9000);
+    for (int k = 0; k < 10; ++k) c.set(random() % 9000, true);
+    b.push_back(c);
+  }
+  a.push_back(bitset(100));
+
+  std::vector<bitset_join::match> ref;
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (size_t j = 0; j < b.size(); ++j) {
+      if (!(a[i] <= b[j])) continue;
+      double s = b[j].count() ? double(a[i].count()) / double(b[j].count()) : 1.0;
+      ref.push_back({i, j, s});
+    }
+  }
+
+  bitset_join join(threads, 8);
+  auto found = join.contained(a, b);
+  REQUIRE(found.size() > a.size() / 4);
+  REQUIRE(found == ref);
+}
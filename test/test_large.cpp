@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../bitset.hpp"
+
+#include <vector>
+
+// sparse bitsets beyond 2^32 bits, the metadata alone takes a few MB
+
+TEST_CASE("large set and get") {
+  const size_t CNT = (1ULL << 33) + 5;
+  const std::vector<size_t> POS = {3, (1ULL << 32) - 1, 1ULL << 32, (1ULL << 32) + 64, 1ULL << 33, CNT - 1};
+
+  bitset b(CNT);
+  REQUIRE(b.capacity() >= CNT);
+
+  for (size_t p : POS) b.set(p, true);
+  REQUIRE(b.count() == POS.size());
+
+  for (size_t p : POS) REQUIRE(b.get(p));
+  // the truncated positions must not alias
+  REQUIRE_FALSE(b.get(0));
+  REQUIRE_FALSE(b.get(64));
+
+  size_t i = 0;
+  for (auto it = b.cbegin(); it != b.cend(); ++it, ++i)
+    REQUIRE(*it == POS[i]);
+  REQUIRE(i == POS.size());
+
+  b.set(1ULL << 32, false);
+  REQUIRE_FALSE(b.get(1ULL << 32));
+  REQUIRE(b.get((1ULL << 32) + 64));
+  REQUIRE(b.count() == POS.size() - 1);
+}
+
+TEST_CASE("large operations") {
+  const size_t CNT = (1ULL << 32) + 4096;
+
+  bitset a(CNT), b(CNT);
+  a.set(1ULL << 32, true);
+  a.set(7, true);
+  b.set((1ULL << 32) + 1, true);
+
+  bitset c = a | b;
+  REQUIRE(c.count() == 3);
+  REQUIRE(c.get(1ULL << 32));
+  REQUIRE(c.get((1ULL << 32) + 1));
+  REQUIRE(a <= c);
+
+  c.shift_right(1ULL << 32);
+  REQUIRE(c.count() == 2);
+  REQUIRE(c.get(0));
+  REQUIRE(c.get(1));
+}
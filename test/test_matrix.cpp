@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bit_matrix.hpp"
+#include "helper.hpp"
+
+#include <tuple>
+#include <vector>
+
+using matrix_reference = std::vector<reference>;
+
+static bit_matrix random_matrix(size_t rows, size_t cols, unsigned density, matrix_reference &ref) {
+  bit_matrix m(rows, cols);
+  ref.resize(rows);
+  for (size_t r = 0; r < rows; ++r) {
+    m.set_row(r, random_bitset(cols, density, ref[r]));
+    ref[r].resize(cols);
+  }
+  return m;
+}
+
+static void require_equal(const bit_matrix &m, const matrix_reference &ref) {
+  REQUIRE(m.rows() == ref.size());
+  for (size_t r = 0; r < ref.size(); ++r) {
+    REQUIRE(m.cols() == ref[r].size());
+    require_equal(m.row(r), ref[r]);
+    for (size_t c = 0; c < ref[r].size(); ++c)
+      REQUIRE(m.get(r, c) == ref[r][c]);
+  }
+}
+
+TEST_CASE("matrix: get and set") {
+  const size_t ROWS = 70, COLS = 9000;
+  matrix_reference ref(ROWS, reference(COLS));
+  bit_matrix m(ROWS, COLS);
+
+  for (int i = 0; i < 20000; ++i) {
+    size_t r = random() % ROWS, c = random() % COLS;
+    bool v = random() % 3;
+    m.set(r, c, v);
+    ref[r][c] = v;
+  }
+  require_equal(m, ref);
+
+  // unused words are reclaimed
+  bit_matrix copy = m;
+  copy.compact();
+  REQUIRE(copy.arena_size() <= m.arena_size());
+  require_equal(copy, ref);
+
+  // clearing a row gives the space back
+  for (size_t r = 0; r < ROWS; ++r)
+    m.set_row(r, bitset(COLS));
+  m.compact();
+  REQUIRE(m.arena_size() == ROWS);
+}
+
+TEST_CASE("matrix: rows") {
+  const size_t ROWS = 10, COLS = 9000;
+  bit_matrix m(ROWS, COLS);
+
+  bitset b(COLS);
+  for (int i = 0; i < 500; ++i) b.set(random() % COLS, true);
+  m.set_row(3, b);
+  REQUIRE(m.row(3) == b);
+  REQUIRE(m.row(3).count() == b.count());
+  REQUIRE(m.row(3).capacity() == b.capacity());
+  REQUIRE(m.row(2) == bitset(COLS));
+  REQUIRE(m.row(2).capacity() == b.capacity());
+
+  // a sparse row only keeps the metadata it needs
+  bitset s(COLS);
+  s.set(5, true);
+  m.set_row(4, s);
+  REQUIRE(m.row(4) == s);
+  REQUIRE(m.count(4) == 1);
+}
+
+TEST_CASE("matrix: row operations") {
+  const size_t ROWS = 4, COLS = 9000;
+  bit_matrix m(ROWS, COLS);
+
+  bitset a(COLS), b(COLS);
+  for (int i = 0; i < 2000; ++i) {
+    unsigned r = random();
+    size_t p = random() % COLS;
+    a.set(p, r & 0x1);
+    b.set(p, r & 0x2);
+  }
+
+  using op = bit_matrix::op;
+  const auto check = [&](op o, const bitset &ref) {
+    m.set_row(0, a);
+    m.set_row(1, b);
+    REQUIRE(m.apply(o, 0, 1) == (ref != a));
+    REQUIRE(m.row(0) == ref);
+    REQUIRE(m.row(1) == b);
+
+    m.set_row(0, a);
+    REQUIRE(m.apply(o, 0, b) == (ref != a));
+    REQUIRE(m.row(0) == ref);
+  };
+  check(op::intersect, a & b);
+  check(op::unite, a | b);
+  check(op::symmetric_difference, a ^ b);
+  check(op::difference, a - b);
+
+  m.set_row(0, a);
+  REQUIRE(m.apply(op::unite, 0, 1));
+  REQUIRE_FALSE(m.apply(op::unite, 0, 1));
+  REQUIRE_FALSE(m.apply(op::unite, 0, 2));
+  REQUIRE(m.apply(op::intersect, 0, 2));
+  REQUIRE(m.count(0) == 0);
+}
+
+TEST_CASE("matrix: row operations drop bits beyond the columns") {
+  const size_t COLS = GENERATE(10, 64, 100, 4032, 4100);
+  bit_matrix m(2, COLS);
+  m.set(0, COLS - 1, true);
+
+  bitset b(COLS + 5000);
+  for (size_t c : {size_t(0), COLS - 1, COLS, COLS + 1, COLS + 70, COLS + 4999})
+    b.set(c, true);
+  using op = bit_matrix::op;
+  REQUIRE(m.apply(op::unite, 1, b));
+  REQUIRE(m.count(1) == 2);
+  REQUIRE(m.get(1, 0));
+  REQUIRE(m.get(1, COLS - 1));
+  REQUIRE(m.apply(op::symmetric_difference, 0, b));
+  REQUIRE(m.count(0) == 1);
+  REQUIRE_FALSE(m.apply(op::unite, 1, b));
+
+  bit_matrix t = m.transpose();
+  REQUIRE(t.rows() == COLS);
+  REQUIRE(t.get(0, 0));
+  REQUIRE(t.get(0, 1));
+  REQUIRE(t.get(COLS - 1, 1));
+  REQUIRE_FALSE(t.get(COLS - 1, 0));
+}
+
+TEST_CASE("matrix: or of rows") {
+  const size_t ROWS = 50, COLS = 9000;
+  matrix_reference ref;
+  bit_matrix m = random_matrix(ROWS, COLS, 2, ref);
+
+  bitset sel(ROWS);
+  for (size_t r = 0; r < ROWS; r += 3) sel.set(r, true);
+
+  bitset u = m.or_rows(sel);
+  REQUIRE(u.capacity() >= COLS);
+  size_t cnt = 0;
+  for (size_t c = 0; c < COLS; ++c) {
+    bool v = false;
+    for (size_t r = 0; r < ROWS; r += 3) v = v || ref[r][c];
+    REQUIRE(u.get(c) == v);
+    cnt += v;
+  }
+  REQUIRE(u.count() == cnt);
+  REQUIRE(m.or_rows(bitset(ROWS)).empty());
+}
+
+TEST_CASE("matrix: transitive closure") {
+  const size_t N = 200;
+  matrix_reference ref;
+  bit_matrix m = random_matrix(N, N, 1, ref);
+
+  // reachability by or_rows from every vertex
+  bit_matrix closure(N, N);
+  for (size_t v = 0; v < N; ++v) {
+    bitset frontier(N), seen(N);
+    frontier.set(v, true);
+    while (!frontier.empty()) {
+      bitset next = m.or_rows(frontier);
+      next -= seen;
+      seen |= next;
+      frontier = next;
+    }
+    closure.set_row(v, seen);
+  }
+
+  // Floyd-Warshall
+  for (size_t k = 0; k < N; ++k)
+    for (size_t i = 0; i < N; ++i)
+      if (ref[i][k])
+        for (size_t j = 0; j < N; ++j)
+          if (ref[k][j]) ref[i][j] = true;
+  require_equal(closure, ref);
+}
+
+TEST_CASE("matrix: transpose") {
+  auto [rows, cols, density] = GENERATE(
+      std::tuple<size_t, size_t, unsigned>{1, 1, 50},
+      std::tuple<size_t, size_t, unsigned>{130, 70, 30},
+      std::tuple<size_t, size_t, unsigned>{70, 9000, 1},
+      std::tuple<size_t, size_t, unsigned>{9000, 70, 90});
+  matrix_reference ref;
+  bit_matrix m = random_matrix(rows, cols, density, ref);
+
+  bit_matrix t = m.transpose();
+  REQUIRE(t.rows() == cols);
+  REQUIRE(t.cols() == rows);
+  for (size_t r = 0; r < rows; ++r)
+    for (size_t c = 0; c < cols; ++c)
+      REQUIRE(t.get(c, r) == ref[r][c]);
+
+  require_equal(t.transpose(), ref);
+}
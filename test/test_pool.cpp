@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../bitset_pool.hpp"
+
+TEST_CASE("pool interns equal bitsets") {
+  bitset_pool pool;
+
+  bitset a(100), b(200);
+  a.set(3, true);
+  b.set(3, true);
+
+  auto ha = pool.intern(a);
+  auto hb = pool.intern(b);
+  REQUIRE(ha == hb);
+  REQUIRE(ha.get() == hb.get());
+  REQUIRE(pool.size() == 1);
+
+  b.set(4, true);
+  auto hc = pool.intern(b);
+  REQUIRE(hc != ha);
+  REQUIRE(*hc == b);
+  REQUIRE(pool.size() == 2);
+}
+
+TEST_CASE("pool keeps the capacity of interned bitsets") {
+  bitset_pool pool;
+
+  bitset a(10), b(100000);
+  auto ha = pool.intern(a);
+  auto hb = pool.intern(b);
+  REQUIRE(ha != hb);
+  REQUIRE(hb->capacity() == b.capacity());
+  REQUIRE_FALSE(hb->get(90000));
+  REQUIRE(pool.size() == 2);
+  REQUIRE(pool.intern(bitset(100000)) == hb);
+}
+
+TEST_CASE("pool releases unused bitsets") {
+  bitset_pool pool(0);
+  {
+    bitset a(100);
+    a.set(1, true);
+    auto h = pool.intern(a);
+    REQUIRE(pool.size() == 1);
+  }
+  REQUIRE(pool.size() == 0);
+
+  for (int i = 0; i < 1000; ++i) {
+    bitset a(1000);
+    a.set(i, true);
+    pool.intern(a);
+  }
+  REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("pool memoizes operations") {
+  bitset_pool pool(2);
+  using op = bitset_pool::op;
+
+  bitset a(1000), b(1000);
+  a.set(1, true);
+  a.set(2, true);
+  b.set(2, true);
+  b.set(3, true);
+  auto ha = pool.intern(a);
+  auto hb = pool.intern(b);
+
+  auto i1 = pool.apply(op::intersect, ha, hb);
+  auto i2 = pool.apply(op::intersect, hb, ha);
+  REQUIRE(i1 == i2);
+  REQUIRE(*i1 == (a & b));
+
+  auto u = pool.apply(op::unite, ha, hb);
+  REQUIRE(*u == (a | b));
+  REQUIRE(*pool.apply(op::symmetric_difference, ha, hb) == (a ^ b));
+
+  // evicted, but still interned
+  auto d1 = pool.apply(op::difference, ha, hb);
+  auto d2 = pool.apply(op::difference, hb, ha);
+  REQUIRE(*d1 == (a - b));
+  REQUIRE(*d2 == (b - a));
+  REQUIRE(d1 != d2);
+  REQUIRE(pool.apply(op::intersect, ha, hb) == i1);
+
+  // results are interned as well
+  REQUIRE(pool.apply(op::unite, ha, i1) == ha);
+}
@@ -263,3 +263,70 @@ TEST_CASE("ref: subset-proper") {
   bool r = r1 <= r2;
   REQUIRE(b == r);
 }
+
+TEST_CASE("different capacities") {
+  const size_t MAX = 12000;
+  const size_t SML = 3000;
+  const size_t RND = 2000;
+
+  bitset b1(SML), b2(MAX);
+  std::bitset<MAX> r1, r2;
+
+  for (int i = 0; i < RND; ++i) {
+    unsigned r = random() % SML;
+    b1.set(r, true);
+    r1.set(r, true);
+    r = random() % MAX;
+    b2.set(r, true);
+    r2.set(r, true);
+  }
+
+  REQUIRE((b1 & b2) == (r1 & r2));
+  REQUIRE((b2 & b1) == (r1 & r2));
+  REQUIRE((b1 | b2) == (r1 | r2));
+  REQUIRE((b1 ^ b2) == (r1 ^ r2));
+  REQUIRE((b1 - b2) == (r1 & ~r2));
+  REQUIRE((b2 - b1) == (r2 & ~r1));
+  REQUIRE((b1 | b2).capacity() == b2.capacity());
+
+  bitset a = b1;
+  a &= b2;
+  REQUIRE(a.capacity() == b1.capacity());
+  REQUIRE(a == (b1 & b2));
+
+  a = b1;
+  a |= b2;
+  REQUIRE(a.capacity() == b2.capacity());
+  REQUIRE(a == (r1 | r2));
+
+  a = b1;
+  a ^= b2;
+  REQUIRE(a == (r1 ^ r2));
+
+  a = b2;
+  a &= b1;
+  REQUIRE(a == (r1 & r2));
+}
+
+TEST_CASE("grow only if needed") {
+  bitset small(100), large(3 * 4032);
+  large.set(4032 + 5, true);
+  large.set(5, true);
+
+  bitset a = small;
+  a &= large;
+  REQUIRE(a.capacity() == 4032);
+
+  large.set(4032 + 5, false);
+  a |= large;
+  REQUIRE(a.capacity() == 4032);
+  REQUIRE(a.get(5));
+  REQUIRE(a == large);
+  REQUIRE_FALSE(a != large);
+
+  large.set(4032 + 5, true);
+  REQUIRE(a != large);
+  a |= large;
+  REQUIRE(a.capacity() == 2 * 4032);
+  REQUIRE(a == large);
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+
+#include <random>
+#include <set>
+#include <vector>
+
+TEST_CASE("select") {
+  const size_t MAX = GENERATE(10, 4032, 3 * 4032 + 5);
+  const size_t RND = GENERATE(0, 1, 100, 2000);
+
+  bitset b(MAX);
+  for (int i = 0; i < RND; ++i)
+    b.set(random() % MAX, true);
+
+  size_t k = 0;
+  for (auto it = b.cbegin(); it != b.cend(); ++it, ++k)
+    REQUIRE(b.select(k) == *it);
+  REQUIRE(k == b.count());
+  REQUIRE(b.select(k) == bitset::npos);
+
+  b.track_count(false);
+  REQUIRE(b.select(k) == bitset::npos);
+}
+
+TEST_CASE("select small words") {
+  basic_bitset<uint8_t, 3> b(1000);
+  std::vector<size_t> ref = {0, 7, 8, 30, 31, 500, 999};
+  for (size_t p : ref) b.set(p, true);
+
+  for (size_t k = 0; k < ref.size(); ++k)
+    REQUIRE(b.select(k) == ref[k]);
+}
+
+TEST_CASE("sample") {
+  const size_t MAX = 3 * 4032;
+  std::mt19937_64 rng(42);
+
+  bitset b(MAX);
+  for (size_t i = 0; i < MAX; i += 7)
+    b.set(i, true);
+
+  const size_t N = GENERATE(0, 1, 50, 1000);
+  auto s = b.sample(N, rng);
+  REQUIRE(s.size() == N);
+  REQUIRE(std::set<size_t>(s.begin(), s.end()).size() == N);
+  REQUIRE(std::is_sorted(s.begin(), s.end()));
+  for (size_t p : s)
+    REQUIRE(b.get(p));
+
+  // asking for more than available returns all bits
+  auto all = b.sample(b.count() + 10, rng);
+  REQUIRE(all.size() == b.count());
+}
+
+TEST_CASE("sample is uniform") {
+  std::mt19937_64 rng(7);
+  bitset b(4032 * 2);
+  const std::vector<size_t> pos = {1, 64, 200, 4031, 4032, 8000};
+  for (size_t p : pos) b.set(p, true);
+
+  std::vector<size_t> hits(b.capacity());
+  const size_t ROUNDS = 6000;
+  for (size_t r = 0; r < ROUNDS; ++r)
+    for (size_t p : b.sample(2, rng))
+      ++hits[p];
+
+  // each bit is expected ROUNDS * 2 / 6 = 2000 times
+  for (size_t p : pos) {
+    REQUIRE(hits[p] > 1700);
+    REQUIRE(hits[p] < 2300);
+  }
+}
@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "../bitset.hpp"
+#include "helper.hpp"
+
+#include <bitset>
+
+TEST_CASE("shift") {
+  const size_t MAX = 3 * 4032;
+  const size_t RND = 1500;
+  const size_t K = GENERATE(0, 1, 5, 63, 64, 65, 128, 1000, 4032, 4033, 8064, 9000, 3 * 4032);
+
+  bitset b(MAX);
+  std::bitset<MAX> r;
+
+  for (int i = 0; i < RND; ++i) {
+    unsigned p = random() % MAX;
+    b.set(p, true);
+    r.set(p, true);
+  }
+
+  bitset bl = b << K;
+  REQUIRE(bl.capacity() == MAX);
+  REQUIRE(bl == (r << K));
+  REQUIRE(bl.count() == (r << K).count());
+
+  bitset br = b >> K;
+  REQUIRE(br == (r >> K));
+  REQUIRE(br.count() == (r >> K).count());
+
+  b <<= K;
+  b >>= K;
+  REQUIRE(b == ((r << K) >> K));
+}
+
+TEST_CASE("offset copy") {
+  const size_t MAX = 2 * 4032;
+  const size_t RND = 500;
+  const int K = GENERATE(-4100, -64, -3, 0, 3, 64, 200, 4032);
+
+  bitset b(MAX);
+  std::bitset<3 * MAX> r;
+
+  for (int i = 0; i < RND; ++i) {
+    unsigned p = random() % MAX;
+    b.set(p, true);
+    if ((int) p + K >= 0) r.set(p + K, true);
+  }
+
+  bitset o = b.offset_copy(K);
+  REQUIRE(o.capacity() >= MAX + std::max(K, 0));
+  REQUIRE(o.count() == r.count());
+
+  auto it = o.cbegin();
+  for (size_t i = 0; i < r.size(); ++i) {
+    if (!r[i]) continue;
+    REQUIRE(it != o.cend());
+    REQUIRE(*it == i);
+    ++it;
+  }
+  REQUIRE(it == o.cend());
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include "helper.hpp"
+
+#include <string>
+
+static bitset random_runs(size_t size, unsigned density) {
+  reference ref;
+  bitset b = random_bitset(size, density, ref);
+  // long runs
+  for (size_t i = size / 3; i < size / 2; ++i) b.set(i, density > 50);
+  return b;
+}
+
+TEST_CASE("string: bits") {
+  bitset b(100);
+  REQUIRE(b.to_string() == "...");
+  b.set(0, true);
+  b.set(9, true);
+  std::string s = b.to_string();
+  REQUIRE(s.starts_with("10000000 01000000 "));
+  REQUIRE(s.ends_with(" ..."));
+  REQUIRE(s.size() == 64 + 7 + 4);
+
+  bitset p;
+  REQUIRE(bitset::from_string("1000 0000 01", p));
+  REQUIRE(p.count() == 2);
+  REQUIRE(p.get(0));
+  REQUIRE(p.get(9));
+  REQUIRE(p.capacity() >= 10);
+  REQUIRE_FALSE(bitset::from_string("10x1", p));
+  REQUIRE(p.count() == 2);
+
+  const size_t size = GENERATE(1, 100, 20000);
+  const unsigned density = GENERATE(0, 5, 95);
+  bitset r = random_runs(size, density);
+  REQUIRE(bitset::from_string(r.to_string(), p));
+  REQUIRE(p == r);
+  REQUIRE(p.count() == r.count());
+}
+
+TEST_CASE("string: hex") {
+  bitset b(200);
+  REQUIRE(b.to_hex() == "0");
+  b.set(0, true);
+  b.set(4, true);
+  b.set(7, true);
+  REQUIRE(b.to_hex() == "91");
+  b.set(130, true);
+  REQUIRE(b.to_hex() == "400000000000000000000000000000091");
+
+  bitset p;
+  REQUIRE(bitset::from_hex("0x400000000000000000000000000000091", p));
+  REQUIRE(p == b);
+  REQUIRE(bitset::from_hex("FF", p));
+  REQUIRE(p.count() == 8);
+  REQUIRE_FALSE(bitset::from_hex("", p));
+  REQUIRE_FALSE(bitset::from_hex("0x", p));
+  REQUIRE_FALSE(bitset::from_hex("12g", p));
+  REQUIRE(p.count() == 8);
+
+  const size_t size = GENERATE(1, 100, 20000);
+  const unsigned density = GENERATE(0, 5, 95);
+  bitset r = random_runs(size, density);
+  REQUIRE(bitset::from_hex(r.to_hex(), p));
+  REQUIRE(p == r);
+  REQUIRE(p.count() == r.count());
+}
+
+TEST_CASE("string: ranges") {
+  bitset b(300);
+  REQUIRE(b.to_ranges() == "");
+  for (size_t i : {0, 1, 2, 3, 8, 10, 11}) b.set(i, true);
+  for (size_t i = 60; i < 200; ++i) b.set(i, true);
+  b.set(299, true);
+  REQUIRE(b.to_ranges() == "0-3,8,10-11,60-199,299");
+
+  bitset p;
+  REQUIRE(bitset::from_ranges("0-3,8,10-11,60-199,299", p));
+  REQUIRE(p == b);
+  REQUIRE(p.count() == b.count());
+  REQUIRE(p.capacity() >= 300);
+  REQUIRE(bitset::from_ranges("", p));
+  REQUIRE(p.empty());
+  for (const char *bad : {",", "1,", "1-", "3-1", "1,1", "5,2-3", "1 ,2", "-1", "a"})
+    REQUIRE_FALSE(bitset::from_ranges(bad, p));
+  // nothing is allocated for a huge range before the whole input is validated
+  REQUIRE_FALSE(bitset::from_ranges("0-99999999999999,x", p));
+  REQUIRE_FALSE(bitset::from_ranges("0-99999999999999,5", p));
+  REQUIRE(p.empty());
+
+  const size_t size = GENERATE(1, 100, 20000);
+  const unsigned density = GENERATE(0, 5, 95);
+  bitset r = random_runs(size, density);
+  REQUIRE(bitset::from_ranges(r.to_ranges(), p));
+  REQUIRE(p == r);
+  REQUIRE(p.count() == r.count());
+}
+
+TEST_CASE("string: narrow words") {
+  using small = basic_bitset<uint16_t, 5>;
+  small b(1000);
+  for (size_t i = 0; i < 1000; i += 7) b.set(i, true);
+  small p;
+  REQUIRE(small::from_string(b.to_string(), p));
+  REQUIRE(p == b);
+  REQUIRE(small::from_hex(b.to_hex(), p));
+  REQUIRE(p == b);
+  REQUIRE(small::from_ranges(b.to_ranges(), p));
+  REQUIRE(p == b);
+}
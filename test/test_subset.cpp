@@ -62,3 +62,25 @@ TEST_CASE("subset small") {
   REQUIRE_FALSE(s1 == s2);
   REQUIRE(s1 != s2);
 }
+
+TEST_CASE("subset different capacities") {
+  bitset small(1000), large(12000);
+
+  REQUIRE(small <= large);
+  REQUIRE(large <= small);
+  REQUIRE(small == large);
+
+  small.set(10, true);
+  large.set(10, true);
+  REQUIRE(small <= large);
+  REQUIRE_FALSE(small < large);
+
+  large.set(11000, true);
+  REQUIRE(small < large);
+  REQUIRE(large > small);
+  REQUIRE_FALSE(large <= small);
+
+  small.set(20, true);
+  REQUIRE_FALSE(small <= large);
+  REQUIRE_FALSE(large >= small);
+}